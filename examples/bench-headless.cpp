@@ -0,0 +1,183 @@
+/**
+ * Renderer benchmark and check using a headless screen.
+ *
+ * Draws a few kinds of frames (full repaints, small updates and a scrolling
+ * chat pane) into a headless `TermScreen` connected to a `VirtualTerminal`.
+ * Each kind of frame damages only what it changes, like scenes do.
+ * After every commit, the grid parsed back by the virtual terminal must match
+ * what was drawn, and the bytes, escape sequences and writes of each kind of
+ * frame are reported.
+ *
+ * Build with (the globs are `?*` as `/` and `*` would open a comment):
+ * ```
+ * clang++ -std=c++20 -O2 -DFMT_HEADER_ONLY -DLOGURU_USE_FMTLIB=1 -Isrc \
+ *     -Isrc/term -Isrc/os -Ivendor/fmt/include -Ivendor/loguru \
+ *     examples/bench-headless.cpp src/term/?*.cpp src/os/?*.cpp \
+ *     vendor/loguru/loguru.cpp -lpthread -ldl -o bench-headless
+ * ```
+ */
+
+#include "term/screen.hpp"
+#include "term/virtual-term.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace uppr;
+using namespace uppr::term;
+
+/**
+ * Check that the virtual terminal shows exactly what was drawn.
+ */
+bool matches(const std::vector<Pixel> &expected, const VirtualTerminal &vt) {
+    const auto [w, h] = vt.get_size();
+    const auto cells = vt.get_cells();
+
+    for (usize y{}; y < h; y++) {
+        for (usize x{}; x < w; x++) {
+            const auto &e = expected[y * w + x];
+            const auto &g = cells[y * w + x];
+            if (e == g) continue;
+
+            std::printf("mismatch at %zu,%zu: expected U+%04X/%016llx, got "
+                        "U+%04X/%016llx\n",
+                        x, y, static_cast<u32>(e.get_glyph()),
+                        static_cast<unsigned long long>(
+                            e.get_packed_style().bits()),
+                        static_cast<u32>(g.get_glyph()),
+                        static_cast<unsigned long long>(
+                            g.get_packed_style().bits()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Draw the frames given by `draw(screen, frame)` and report the cost of them.
+ */
+template <typename F>
+bool run(const char *name, Size size, usize frames, F &&draw) {
+    using namespace std::chrono;
+
+    VirtualTerminal vt{size};
+    TermScreen screen{size, vt.sink()};
+
+    // Settle the initial clear and full repaint, so it is not measured
+    screen.clear();
+    screen.commit();
+
+    const auto before = vt.get_stats();
+    std::vector<Pixel> expected;
+    nanoseconds elapsed{};
+    nanoseconds drawing{};
+
+    for (usize i{}; i < frames; i++) {
+        screen.clear();
+
+        const auto draw_start = steady_clock::now();
+        draw(screen, i);
+        drawing += steady_clock::now() - draw_start;
+
+        // Everything is new on the first frame, like after switching scenes
+        if (i == 0) screen.damage_all();
+
+        const auto buffer = screen.get_buffer();
+        expected.assign(buffer.begin(), buffer.end());
+
+        const auto start = steady_clock::now();
+        screen.commit();
+        elapsed += steady_clock::now() - start;
+
+        if (!matches(expected, vt)) {
+            std::printf("%s: frame %zu does not match\n", name, i);
+            return false;
+        }
+    }
+
+    const auto &after = vt.get_stats();
+    const auto per_frame = [&](usize a, usize b) {
+        return static_cast<double>(a - b) / frames;
+    };
+
+    std::printf("%-14s %4zux%-4zu %8.1f bytes %7.1f escapes %5.2f writes "
+                "%7.2f us/draw %8.2f us/commit\n",
+                name, size.getx(), size.gety(),
+                per_frame(after.bytes, before.bytes),
+                per_frame(after.escapes, before.escapes),
+                per_frame(after.writes, before.writes),
+                duration<double, std::micro>(drawing).count() / frames,
+                duration<double, std::micro>(elapsed).count() / frames);
+
+    return true;
+}
+
+int main() {
+    loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+
+    const auto styled = fmt::fg(fmt::color::orange) | fmt::emphasis::bold;
+
+    bool ok = true;
+    for (const Size size : {Size{80, 24}, Size{200, 60}}) {
+        const auto [w, h] = size;
+
+        // Every cell changes on every frame
+        ok &= run("repaint", size, 200, [&](TermScreen &s, usize frame) {
+            for (usize y{}; y < h; y++) {
+                s.print(0, y, (frame + y) % 2 ? styled : fmt::text_style{},
+                        "{:>{}}", frame * 31 + y, w);
+            }
+            s.damage_all();
+        });
+
+        // A clock and a counter change, the rest stays
+        ok &= run("small", size, 200, [&](TermScreen &s, usize frame) {
+            s.box({0, 0}, w - 1, h - 1, {});
+            s.print(2, 1, styled, "Frame {:06d}", frame);
+            s.print(w - 20, h - 2, "{:>10} ms", frame * 33);
+            for (usize y{3}; y < h - 3; y += 2)
+                s.print(4, y, "Some text that does not change ({})", y);
+
+            s.damage({{2, 1}, {12, 1}});
+            s.damage({{static_cast<int>(w) - 20, static_cast<int>(h) - 2},
+                      {13, 1}});
+        });
+
+        // New chat messages push the old ones up, like `ChatScene`. With a
+        // sidebar, the pane needs left/right margins to be scrolled.
+        for (const usize left : {usize{}, w / 3}) {
+            const auto chat = [&, left](TermScreen &s, usize frame) {
+                const int x = static_cast<int>(left);
+                const int top = 2;
+                const int bottom = static_cast<int>(h) - 3;
+
+                if (left) s.vline(x - 1, 0, h, '|');
+                s.hline(x, w, top - 1, '=');
+                s.hline(x, w, bottom, '=');
+
+                // One new message every other frame
+                const auto newest = frame / 2;
+                const Size pane{w - left, static_cast<usize>(bottom - top)};
+                if (frame % 2 == 0 && frame > 0) {
+                    s.scroll_region({x, top}, pane, 2);
+                    s.damage({{x, top}, pane});
+                }
+
+                int y = bottom - 2;
+                for (usize m = newest; y >= top; y -= 2, m--) {
+                    s.print(x, y, m % 3 ? fmt::text_style{} : styled,
+                            "{} {}: message number {} ✓", m % 2 ? " >" : "<<",
+                            m % 2 ? "them" : "me", m);
+                    if (m == 0) break;
+                }
+            };
+
+            ok &= run(left ? "chat+sidebar" : "chat", size, 200, chat);
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
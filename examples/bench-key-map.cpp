@@ -0,0 +1,147 @@
+/**
+ * Microbenchmark for key dispatch.
+ *
+ * Dispatches a synthetic stream of keystrokes (mostly typing, with some
+ * navigation and key bindings mixed in) through the engine's `KeyMap` and
+ * through the `eventpp::EventDispatcher` that the engine used before, with
+ * about the same listeners that the app registers. Then does it again with a
+ * modal that has the focus, which `eventpp` has no equivalent for.
+ *
+ * Build with:
+ * ```
+ * clang++ -std=c++20 -O2 -DFMT_HEADER_ONLY -DLOGURU_USE_FMTLIB=1 -Isrc \
+ *     -Isrc/eng -Ivendor/fmt/include -Ivendor/loguru \
+ *     -Ivendor/eventpp/include examples/bench-key-map.cpp \
+ *     src/eng/key-map.cpp -o bench-key-map
+ * ```
+ */
+
+#include "eng/key-map.hpp"
+#include "eventpp/eventdispatcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace uppr;
+using namespace uppr::eng;
+
+using Key = Event::NonChar;
+
+namespace {
+
+constexpr char ctrl(char c) { return c & 0x1F; }
+
+/**
+ * The keys that the app listens to.
+ */
+const std::vector<Event> bound_keys{
+    'c',       'm',       '\r',      '\t',      Key::shift_tab, Key::esc,
+    Key::paste, ctrl('u'), ctrl('c'), ctrl('a'), ctrl('d'),     ctrl('e'),
+};
+
+/**
+ * A million keys, most of them are letters that nobody listens to.
+ */
+std::vector<Event> make_stream() {
+    std::mt19937 rng{42};
+    std::vector<Event> keys;
+    keys.reserve(1'000'000);
+
+    const Key nav[]{Key::up, Key::down, Key::left, Key::right, Key::home,
+                    Key::end};
+
+    while (keys.size() < 1'000'000) {
+        const auto r = rng() % 100;
+        if (r < 85)
+            keys.emplace_back(static_cast<char>('a' + rng() % 26));
+        else if (r < 92)
+            keys.emplace_back(' ');
+        else if (r < 97)
+            keys.emplace_back(nav[rng() % std::size(nav)]);
+        else
+            keys.push_back(bound_keys[rng() % bound_keys.size()]);
+    }
+
+    return keys;
+}
+
+template <typename F> double time_ms(F &&f) {
+    using namespace std::chrono;
+
+    const auto start = steady_clock::now();
+    f();
+    const auto end = steady_clock::now();
+
+    return duration_cast<microseconds>(end - start).count() / 1000.0;
+}
+} // namespace
+
+int main() {
+    const auto stream = make_stream();
+
+    // The owners are only compared, never used, so anything unique will do
+    const int scenes[2]{};
+    const auto *main_scene = reinterpret_cast<const Scene *>(&scenes[0]);
+    const auto *modal = reinterpret_cast<const Scene *>(&scenes[1]);
+
+    usize eventpp_calls{};
+    usize keymap_calls{};
+    usize focused_calls{};
+
+    eventpp::EventDispatcher<Event, void(Event)> bus;
+    KeyMap keymap;
+
+    // Every bound key has a listener in the main scene, and the ones that the
+    // modals use have another one in the modal
+    for (const auto k : bound_keys) {
+        bus.appendListener(k, [&](Event) { eventpp_calls++; });
+        keymap.add_listener(k, [&](Event) { keymap_calls++; }, main_scene);
+    }
+
+    for (const auto k : {Event{'\r'}, Event{'\t'}, Event{Key::shift_tab},
+                         Event{Key::paste}}) {
+        bus.appendListener(k, [&](Event) { eventpp_calls++; });
+        keymap.add_listener(
+            k,
+            [&](Event) {
+                keymap_calls++;
+                focused_calls++;
+            },
+            modal);
+    }
+
+    // Warm up both, so that nothing is allocated while timing
+    for (const auto e : stream) bus.dispatch(e, e);
+    for (const auto e : stream) keymap.dispatch(e);
+    eventpp_calls = keymap_calls = focused_calls = 0;
+
+    const auto eventpp_ms = time_ms([&] {
+        for (const auto e : stream) bus.dispatch(e, e);
+    });
+
+    const auto keymap_ms = time_ms([&] {
+        for (const auto e : stream) keymap.dispatch(e);
+    });
+
+    const auto all_calls = keymap_calls;
+    keymap_calls = 0;
+
+    keymap.push_focus(modal);
+    const auto focused_ms = time_ms([&] {
+        for (const auto e : stream) keymap.dispatch(e);
+    });
+
+    std::printf("%zu keys, %zu listeners called\n", stream.size(),
+                eventpp_calls);
+    std::printf("%-18s %10s %10s %10s\n", "", "total ms", "ns/key", "calls");
+    std::printf("%-18s %10.2f %10.2f %10zu\n", "eventpp", eventpp_ms,
+                eventpp_ms * 1e6 / stream.size(), eventpp_calls);
+    std::printf("%-18s %10.2f %10.2f %10zu\n", "keymap", keymap_ms,
+                keymap_ms * 1e6 / stream.size(), all_calls);
+    std::printf("%-18s %10.2f %10.2f %10zu\n", "keymap (focused)",
+                focused_ms, focused_ms * 1e6 / stream.size(), focused_calls);
+
+    return eventpp_calls == all_calls ? 0 : 1;
+}
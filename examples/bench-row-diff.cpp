@@ -0,0 +1,120 @@
+/**
+ * Microbenchmark for the screen damage detection.
+ *
+ * Compares the vectorized row comparators against a plain loop over the
+ * pixels, on a few common terminal sizes.
+ *
+ * Build with:
+ * ```
+ * clang++ -std=c++20 -O2 -Isrc -Ivendor/fmt/include -Ivendor/loguru \
+ *     examples/bench-row-diff.cpp src/term/row-diff.cpp -o bench-row-diff
+ * ```
+ */
+
+#include "term/pixel.hpp"
+#include "term/row-diff.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace uppr;
+using namespace uppr::term;
+
+/**
+ * The most naive way of doing it: compare every pixel of every row.
+ */
+DirtySpan diff_row_loop(const Pixel *a, const Pixel *b, usize n) {
+    DirtySpan span;
+    for (usize i{}; i < n; i++) {
+        if (a[i] == b[i]) continue;
+
+        if (!span.dirty) span.first = i;
+        span.last = i;
+        span.dirty = true;
+    }
+
+    return span;
+}
+
+/**
+ * Run `fn` over every row of both buffers many times, returning the average
+ * time of a full screen in nanoseconds.
+ */
+double bench(RowDiffFn fn, const std::vector<Pixel> &a,
+             const std::vector<Pixel> &b, usize w, usize h) {
+    using namespace std::chrono;
+
+    constexpr usize iterations = 2000;
+    usize sink{};
+
+    const auto start = steady_clock::now();
+    for (usize it{}; it < iterations; it++) {
+        for (usize j{}; j < h; j++) {
+            const auto span = fn(a.data() + j * w, b.data() + j * w, w);
+            sink += span.first + span.last + span.dirty;
+        }
+    }
+    const auto end = steady_clock::now();
+
+    // Make shure the compiler does not throw it all away
+    if (sink == 42) std::puts("");
+
+    return duration_cast<nanoseconds>(end - start).count() /
+           static_cast<double>(iterations);
+}
+
+int main() {
+    using namespace fmt;
+
+    struct Case {
+        const char *name;
+        usize changes_per_row;
+    };
+
+    constexpr std::pair<usize, usize> sizes[]{{80, 24}, {200, 60}, {400, 120}};
+    constexpr Case cases[]{{"idle", 0}, {"1 cell/row", 1}, {"8 cells/row", 8}};
+
+    std::mt19937 rng{42};
+
+    std::printf("%-10s %-12s %10s %10s %10s %10s\n", "size", "case",
+                "loop ns", "scalar ns", "sse2 ns", "avx2 ns");
+
+    for (const auto &[w, h] : sizes) {
+        for (const auto &c : cases) {
+            // Fill one buffer with something that looks like a UI
+            std::vector<Pixel> a(w * h);
+            for (usize i{}; i < a.size(); i++) {
+                const auto style = i % 7 ? text_style{} : emphasis::bold;
+                a[i] = Pixel{static_cast<char>('a' + i % 26), style};
+            }
+
+            // And the other with some random changes
+            auto b = a;
+            for (usize j{}; j < h; j++) {
+                for (usize k{}; k < c.changes_per_row; k++)
+                    b[j * w + rng() % w] = Pixel{'#'};
+            }
+
+            const auto size = std::to_string(w) + "x" + std::to_string(h);
+            std::printf("%-10s %-12s %10.0f %10.0f", size.c_str(), c.name,
+                        bench(diff_row_loop, a, b, w, h),
+                        bench(diff_row_scalar, a, b, w, h));
+            // Columns that this CPU cant run are still there, to keep the
+            // table aligned
+#if defined(__x86_64__)
+            std::printf(" %10.0f", bench(diff_row_sse2, a, b, w, h));
+            if (select_row_diff() == diff_row_avx2)
+                std::printf(" %10.0f", bench(diff_row_avx2, a, b, w, h));
+            else
+                std::printf(" %10s", "n/a");
+#else
+            std::printf(" %10s %10s", "n/a", "n/a");
+#endif
+            std::printf("\n");
+        }
+    }
+
+    return 0;
+}
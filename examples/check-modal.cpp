@@ -0,0 +1,142 @@
+/**
+ * Check that showing and hiding a modal leaves the terminal as drawn.
+ *
+ * A background scene fills the screen once and then damages nothing, like
+ * scenes that did not change, and a `ModalScene` over it is shown and hidden
+ * a few times. Its child draws a box like the modals of the app do, which
+ * goes one past its size, so both showing and hiding it must damage its
+ * right and bottom edges too. After every frame, the grid parsed back by a
+ * `VirtualTerminal` must match what was drawn.
+ *
+ * Build with (the globs are `?*` as `/` and `*` would open a comment):
+ * ```
+ * clang++ -std=c++20 -O2 -DFMT_HEADER_ONLY -DLOGURU_USE_FMTLIB=1 -Isrc \
+ *     -Isrc/eng -Isrc/term -Isrc/os -Ivendor/fmt/include -Ivendor/loguru \
+ *     examples/check-modal.cpp src/eng/?*.cpp src/term/?*.cpp src/os/?*.cpp \
+ *     vendor/loguru/loguru.cpp -lpthread -ldl -o check-modal
+ * ```
+ */
+
+#include "eng/engine.hpp"
+#include "eng/modal-scene.hpp"
+#include "eng/stack-scene.hpp"
+#include "term/screen.hpp"
+#include "term/virtual-term.hpp"
+
+#include <cstdio>
+#include <utility>
+
+using namespace uppr;
+using namespace uppr::term;
+
+/**
+ * Fills everything with a pattern, but only says so the first time.
+ */
+class Background : public eng::Scene {
+public:
+    void update(eng::Engine &engine) override {}
+
+    void draw(eng::Engine &engine, Transform transform, Size size,
+              TermScreen &screen) override {
+        for (usize y{}; y < size.gety(); y++) {
+            for (usize x{}; x < size.getx(); x++)
+                screen.setc(x, y, static_cast<char>('a' + (x + y) % 26));
+        }
+    }
+
+    void damage(Rect area, TermScreen &screen) override {
+        if (std::exchange(first, false)) screen.damage(area);
+    }
+
+private:
+    bool first{true};
+};
+
+/**
+ * Draws a box over all of its size, like the modals of the app.
+ */
+class Boxed : public eng::Scene {
+public:
+    void update(eng::Engine &engine) override {}
+
+    void draw(eng::Engine &engine, Transform transform, Size size,
+              TermScreen &screen) override {
+        screen.box(transform, size.getx(), size.gety(), {});
+        screen.print(transform.move(1, 1), "modal");
+    }
+};
+
+/**
+ * Check that the virtual terminal shows exactly what was drawn.
+ */
+bool matches(span<const Pixel> expected, const VirtualTerminal &vt) {
+    const auto [w, h] = vt.get_size();
+    const auto cells = vt.get_cells();
+
+    for (usize y{}; y < h; y++) {
+        for (usize x{}; x < w; x++) {
+            const auto &e = expected[y * w + x];
+            const auto &g = cells[y * w + x];
+            if (e == g) continue;
+
+            std::printf("mismatch at %zu,%zu: expected U+%04X, got U+%04X\n",
+                        x, y, static_cast<u32>(e.get_glyph()),
+                        static_cast<u32>(g.get_glyph()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main() {
+    loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+
+    bool ok = true;
+    for (const Size size : {Size{80, 24}, Size{200, 60}, Size{31, 9}}) {
+        VirtualTerminal vt{size};
+        const auto screen = std::make_shared<TermScreen>(size, vt.sink());
+
+        const auto modal = eng::ModalScene::make(std::make_shared<Boxed>());
+        const auto stack = eng::StackScene::make();
+
+        eng::Engine engine{30, screen};
+        stack->add_scene(engine, std::make_shared<Background>());
+        stack->add_scene(engine, modal);
+        engine.switch_scene(stack);
+
+        // Like the frames of the engine, without waiting for anything
+        const auto frame = [&](const char *what, bool repaint = false) {
+            screen->clear();
+            stack->run_draw(engine, {}, size, *screen);
+            stack->damage({{}, size}, *screen);
+            if (repaint) screen->damage_all();
+
+            const auto buffer = screen->get_buffer();
+            const std::vector<Pixel> expected(buffer.begin(), buffer.end());
+            screen->commit();
+
+            if (!matches(expected, vt)) {
+                std::printf("%zux%zu: %s does not match\n", size.getx(),
+                            size.gety(), what);
+                ok = false;
+            }
+        };
+
+        frame("first frame");
+        for (int i{}; i < 3; i++) {
+            modal->show_modal(engine);
+            frame("showing");
+            frame("shown");
+
+            // Hiding must restore the border even if showing did not damage
+            // all of it
+            frame("repainted", true);
+            modal->hide_modal(engine);
+            frame("hiding");
+        }
+    }
+
+    std::printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -43,22 +43,37 @@ void AddUserToChatScene::mount(eng::Engine &engine) {
 
     update_users();
 
-    select_next_keybind_handle =
-        engine.get_eventbus().appendListener('\r', [this](char c) {
-            if (has_user_available) confirm();
-        });
-
-    select_next_keybind_handle = engine.get_eventbus().appendListener(
-        '\t', [this](char c) { select_next_user(); });
+    auto &keymap = engine.get_keymap();
 
-    select_prev_keybind_handle = engine.get_eventbus().appendListener(
-        eng::Event::NonChar::shift_tab, [this](char c) { select_prev_user(); });
+    confirm_keybind_handle = keymap.add_listener(
+        '\r',
+        [this](char c) {
+            if (has_user_available) confirm();
+        },
+        this);
+
+    select_next_keybind_handle = keymap.add_listener(
+        '\t', [this](char c) { select_next_user(); }, this);
+
+    select_prev_keybind_handle = keymap.add_listener(
+        eng::Event::NonChar::shift_tab, [this](char c) { select_prev_user(); },
+        this);
+
+    // Pasting a name selects that user
+    paste_keybind_handle = keymap.add_listener(
+        eng::Event::NonChar::paste,
+        [this, &engine](char c) {
+            const auto text = engine.get_paste();
+            select_user_named(text.substr(0, text.find_first_of("\r\n")));
+        },
+        this);
 }
 
 void AddUserToChatScene::unmount(eng::Engine &engine) {
-    engine.get_eventbus().removeListener('\t', select_next_keybind_handle);
-    engine.get_eventbus().removeListener(eng::Event::NonChar::shift_tab,
-                                         select_prev_keybind_handle);
+    engine.get_keymap().remove_listener(confirm_keybind_handle);
+    engine.get_keymap().remove_listener(select_next_keybind_handle);
+    engine.get_keymap().remove_listener(select_prev_keybind_handle);
+    engine.get_keymap().remove_listener(paste_keybind_handle);
 }
 
 void AddUserToChatScene::update_users() {
@@ -108,6 +123,14 @@ void AddUserToChatScene::select_prev_user() {
     } while (selected_user >= 0 && users[selected_user].second);
 }
 
+void AddUserToChatScene::select_user_named(string_view name) {
+    const auto user = std::ranges::find_if(users, [name](const auto &u) {
+        return !u.second && u.first.name == name;
+    });
+
+    if (user != users.end()) selected_user = std::distance(users.begin(), user);
+}
+
 void AddUserToChatScene::confirm() {
     if (selected_user < 0) {
         LOG_F(ERROR, "No selected user on confirm!");
@@ -43,6 +43,11 @@ private:
      */
     void select_prev_user();
 
+    /**
+     * Select the user with the given name, if they can be added.
+     */
+    void select_user_named(string_view name);
+
     /**
      * Called when we want to save data!
      */
@@ -60,15 +65,22 @@ private:
      */
     std::vector<std::pair<models::UserModel, bool>> users;
 
+    /**
+     * Handle for the callback for confirming the selected user.
+     */
+    eng::KeyMap::Handle confirm_keybind_handle;
+
     /**
      * Handle for the callback for selecting the next input
      */
-    eng::Engine::EventBus::Handle select_next_keybind_handle;
+    eng::KeyMap::Handle select_next_keybind_handle;
 
     /**
      * Handle for the callback for selecting the previous input
      */
-    eng::Engine::EventBus::Handle select_prev_keybind_handle;
+    eng::KeyMap::Handle select_prev_keybind_handle;
+
+    eng::KeyMap::Handle paste_keybind_handle;
 
     /**
      * The currently selected input item.
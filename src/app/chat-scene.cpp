@@ -1,54 +1,112 @@
 #include "chat-scene.hpp"
 #include "key.hpp"
+#include <algorithm>
 
 namespace uppr::app {
 
 void ChatScene::update(eng::Engine &engine) {
-    chat_info->update(engine);
-    write_msg->update(engine);
+    chat_info->run_update(engine);
+    write_msg->run_update(engine);
 }
 
 void ChatScene::draw(eng::Engine &engine, term::Transform transform,
                      term::Size size, term::TermScreen &screen) {
+    // Everything but the input line only changes with the state, so it is
+    // kept in a layer and drawn again only when needed
+    if (needs_redraw() || transform != layer.get_origin() ||
+        size != layer.get_size()) {
+        drawn_generation = state->get_generation();
+
+        screen.push_layer(layer, transform, size);
+        draw_chat(engine, transform, size, screen);
+        screen.pop_layer();
+
+        redrawn = true;
+    }
+
+    screen.blit(layer);
+
+    const term::Transform input_tl{transform.getx(),
+                                   static_cast<int>(size.gety()) - 3};
+    write_msg->run_draw(engine, input_tl, {size.getx(), 2}, screen);
+}
+
+void ChatScene::damage(term::Rect area, term::TermScreen &screen) {
+    if (redrawn) {
+        screen.damage(area);
+        redrawn = false;
+        return;
+    }
+
+    // Only the input line can change without the state changing
+    const term::Rect input{{area.tl.getx(), area.bottom() - 3},
+                           {area.size.getx(), 2}};
+    write_msg->damage(input.intersect(area), screen);
+}
+
+void ChatScene::draw_chat(eng::Engine &engine, term::Transform transform,
+                          term::Size size, term::TermScreen &screen) {
     using namespace fmt;
 
     const auto info_size = term::Size{size.getx(), 5};
+    const auto width = static_cast<int>(size.getx());
 
-    chat_info->draw(engine, transform, info_size, screen);
-    transform += {0, static_cast<int>(info_size.gety())};
+    chat_info->run_draw(engine, transform, info_size, screen);
 
-    screen.hline(transform.getx() + 1, transform.getx() + size.getx() - 1,
-                 transform.gety(), '=');
+    // The rest is drawn relative to the scene
+    auto canvas = screen.canvas(transform, size);
 
-    const auto limit = transform;
+    const int limit = info_size.gety();
+    canvas.hline(1, width - 1, limit, '=');
 
     // Move to the bottom of the screen
-    transform.y = size.gety() - 4;
-    screen.hline(transform.getx() + 1, transform.getx() + size.getx() - 1,
-                 transform.gety(), '=');
-    transform += {0, 1};
+    const int bottom = static_cast<int>(size.gety()) - 4;
+    canvas.hline(1, width - 1, bottom, '=');
+
+    // Everything between the two lines
+    const term::Transform pane_tl{transform.getx(),
+                                  transform.gety() + limit + 1};
+    const term::Size pane_size{
+        size.getx(), static_cast<usize>(std::max(bottom - limit - 1, 0))};
 
-    write_msg->draw(engine, transform, {size.getx(), 2}, screen);
+    const auto messages = state->get_messages_of_current_chat();
+    const auto chat = state->get_selected_chatmodel();
+
+    // Messages are newest first and each takes 2 lines, so if the pane did
+    // not move then new messages just push the old ones up
+    if (chat && chat->id == last_pane.chat_id && pane_tl == last_pane.tl &&
+        pane_size == last_pane.size) {
+        const auto last_newest = std::find_if(
+            messages.begin(), messages.end(), [&](const auto &msg) {
+                return msg.id == last_pane.newest_message_id;
+            });
+
+        const auto pushed = last_newest - messages.begin();
+        if (last_newest != messages.end() && pushed > 0)
+            screen.scroll_region(pane_tl, pane_size,
+                                 static_cast<int>(pushed * 2));
+    }
 
-    transform -= {0, 3};
-    for (const auto &msg : state->get_messages_of_current_chat()) {
+    last_pane = {chat ? chat->id : -1,
+                 messages.empty() ? -1 : messages.front().id, pane_tl,
+                 pane_size};
 
-        auto prefix = " >"s;
-        std::string name;
+    int y = bottom - 2;
+    for (const auto &msg : messages) {
+        // Everything is formatted straight into the line, without building
+        // strings for the name first
         if (msg.sent_by < 0) {
             // Sent by us
-            name = state->get_name();
-            prefix = "<<"s;
+            canvas.print(0, y, "<< {}: {}", state->get_name(), msg.content);
+        } else if (const auto sent_by = state->find_user(msg.sent_by)) {
+            canvas.print(0, y, " > {}: {}", sent_by->get().name, msg.content);
         } else {
-            const auto sent_by = state->find_user(msg.sent_by);
-            name = sent_by ? sent_by->get().name
-                           : fmt::format("[{}]", msg.sent_by);
+            canvas.print(0, y, " > [{}]: {}", msg.sent_by, msg.content);
         }
-        screen.print(transform, "{} {}: {}", prefix, name, msg.content);
-        transform -= {0, 2};
+        y -= 2;
 
         // Stop when we run out of space
-        if (transform.gety() <= limit.gety()) break;
+        if (y <= limit) break;
     }
 }
 
@@ -25,6 +25,12 @@ public:
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
+    bool needs_redraw() const override {
+        return state->get_generation() != drawn_generation;
+    }
+
     void mount(eng::Engine &engine) override;
 
     void unmount(eng::Engine &engine) override;
@@ -33,9 +39,42 @@ public:
         return std::make_shared<ChatScene>(s);
     }
 
+private:
+    /**
+     * Draw everything but the input line.
+     */
+    void draw_chat(eng::Engine &engine, term::Transform transform,
+                   term::Size size, term::TermScreen &screen);
+
 private:
     shared_ptr<AppState> state;
     unique_ptr<ChatInfoScene> chat_info;
     unique_ptr<WriteMsgScene> write_msg;
+
+    /**
+     * What the message pane showed on the last frame, so that new messages
+     * can scroll the old ones instead of printing all of them again.
+     */
+    struct PaneState {
+        int chat_id{-1};
+        int newest_message_id{-1};
+        term::Transform tl{};
+        term::Size size{};
+    } last_pane;
+
+    /**
+     * What `draw_chat` drew last time.
+     */
+    term::Surface layer;
+
+    /**
+     * The generation of the state when `layer` was drawn.
+     */
+    u64 drawn_generation{~0ULL};
+
+    /**
+     * If `layer` was drawn again since the last `damage()`.
+     */
+    bool redrawn{};
 };
 } // namespace uppr::app
@@ -33,19 +33,19 @@ void ChatInfoScene::draw_chat_info(const models::ChatModel &chat,
                                    term::TermScreen &screen) {
     using namespace fmt;
 
-    transform += {0, 1};
-    screen.print(transform, emphasis::bold | emphasis::underline, "{}: {}",
-                 chat.id, chat.name);
-
-    transform += {0, 2};
-
-    std::vector<std::string> stringified;
-    stringified.reserve(users_in_current_chat.size());
-
-    for (const auto &[addr, user] : users_in_current_chat)
-        stringified.push_back(format("{} [{}]", user.name, addr.port));
-
-    screen.print(transform, "members: {}", join(stringified, ", "));
+    auto canvas = screen.canvas(transform, size);
+
+    canvas.print(0, 1, emphasis::bold | emphasis::underline, "{}: {}", chat.id,
+                 chat.name);
+
+    // Each member is printed right after the last one, instead of joining
+    // them into a temporary string
+    int x = canvas.print(0, 3, "members: ");
+    for (usize i{}; i < users_in_current_chat.size(); i++) {
+        const auto &[addr, user] = users_in_current_chat[i];
+        x += canvas.print(x, 3, "{}{} [{}]", i ? ", " : "", user.name,
+                          addr.port);
+    }
 }
 
 void ChatInfoScene::update_users() {
@@ -11,13 +11,19 @@ void ChatViewScene::draw(eng::Engine &engine, term::Transform transform,
                          term::Size size, term::TermScreen &screen) {
     using namespace fmt;
 
-    screen.print(transform, emphasis::bold, "'{}' at port {}",
-                 state->get_name(), state->get_port());
-    transform += {0, 2};
+    drawn_generation = state->get_generation();
 
-    screen.print(transform, emphasis::underline, "> {} Available chats",
+    auto canvas = screen.canvas(transform, size);
+    const auto width = static_cast<int>(size.getx());
+    int y{};
+
+    canvas.print(0, y, emphasis::bold, "'{}' at port {}", state->get_name(),
+                 state->get_port());
+    y += 2;
+
+    canvas.print(0, y, emphasis::underline, "> {} Available chats",
                  state->get_chats().size());
-    transform += {0, 2};
+    y += 2;
 
     usize idx{};
     for (const auto &item : state->get_chats()) {
@@ -28,13 +34,13 @@ void ChatViewScene::draw(eng::Engine &engine, term::Transform transform,
         if (idx == state->get_selected_chat()) {
             name_style |= emphasis::reverse;
         }
-        screen.print(transform.move(1, 0), name_style, "{}", item.name);
+        canvas.print(1, y, name_style, "{}", item.name);
 
         // Print at the right corner the id of the chat
-        screen.print(transform.move(size.getx() - 4, 0), "{:>3}", item.id);
+        canvas.print(width - 4, y, "{:>3}", item.id);
 
         // move one line down
-        transform += term::Transform{0, 1};
+        y++;
 
         // Print the description of the chat (limiting the size and adding
         // '...' if needed)
@@ -42,15 +48,15 @@ void ChatViewScene::draw(eng::Engine &engine, term::Transform transform,
         const auto maxwidth = size.getx() - 4;
         const auto descr =
             static_cast<string_view>(item.description).substr(0, maxwidth);
-        screen.print(transform.move(1, 0), emphasis::faint, "{}{}", descr,
+        canvas.print(1, y, emphasis::faint, "{}{}", descr,
                      item.description.length() > maxwidth ? "..." : "");
 
         // Move 2 lines down and add the horizontal separator
-        transform += term::Transform{0, 2};
-        screen.hline(transform.getx(), size.getx(), transform.gety(), '-');
+        y += 2;
+        canvas.hline(0, width, y, '-');
 
         // Move to the next line before the next iteration
-        transform += term::Transform{0, 1};
+        y++;
         idx++;
     }
 }
@@ -58,14 +64,16 @@ void ChatViewScene::draw(eng::Engine &engine, term::Transform transform,
 void ChatViewScene::mount(eng::Engine &engine) {
     LOG_F(5, "Mount for chatview scene");
 
-    cycle_chat_keybind_handle =
-        engine.get_eventbus().appendListener('c', [this](char c) {
+    cycle_chat_keybind_handle = engine.get_keymap().add_listener(
+        'c',
+        [this](char c) {
             const auto s = state->select_next_chat();
             LOG_F(7, "Selected next chat: {}", s);
-        });
+        },
+        this);
 }
 
 void ChatViewScene::unmount(eng::Engine &engine) {
-    engine.get_eventbus().removeListener('c', cycle_chat_keybind_handle);
+    engine.get_keymap().remove_listener(cycle_chat_keybind_handle);
 }
 } // namespace uppr::app
@@ -16,6 +16,10 @@ public:
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    bool needs_redraw() const override {
+        return state->get_generation() != drawn_generation;
+    }
+
     void mount(eng::Engine &engine) override;
 
     void unmount(eng::Engine &engine) override;
@@ -45,11 +49,16 @@ private:
     /**
      * Handle for the callback for cycling the chat.
      */
-    eng::Engine::EventBus::Handle cycle_chat_keybind_handle;
+    eng::KeyMap::Handle cycle_chat_keybind_handle;
 
     /**
      * If we need to update the chats from the database.
      */
     bool chats_needs_update{true};
+
+    /**
+     * The generation of the state when we last drew.
+     */
+    u64 drawn_generation{~0ULL};
 };
 } // namespace uppr::app
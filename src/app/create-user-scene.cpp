@@ -34,30 +34,41 @@ void CreateUserScene::draw(eng::Engine &engine, term::Transform transform,
         draw_basic_button(Item::confirm, selected_item, create_data.any_empty(),
                           transform, screen, "Create");
 
-    if (wants_input) { confirm(initial, screen); }
+    // The input being edited shows the editor instead, every box is 3 lines
+    if (editing) {
+        const auto row = 1 + 3 * static_cast<int>(selected_item);
+        editor.draw(screen.canvas(initial.move(1, row), {28, 1}),
+                    term::PackedStyle{emphasis::underline});
+    }
 }
 
 void CreateUserScene::mount(eng::Engine &engine) {
     state->fetch_users();
 
-    edit_item_keybind_handle =
-        engine.get_eventbus().appendListener('\r', [this](char c) {
-            wants_input = true;
-            LOG_F(9, "wants input");
-        });
+    auto &keymap = engine.get_keymap();
+
+    edit_item_keybind_handle = keymap.add_listener(
+        '\r', [this, &engine](char c) { confirm(engine); }, this);
 
-    select_next_keybind_handle = engine.get_eventbus().appendListener(
-        '\t', [this](char c) { select_next_item(); });
+    select_next_keybind_handle = keymap.add_listener(
+        '\t', [this](char c) { select_next_item(); }, this);
 
-    select_prev_keybind_handle = engine.get_eventbus().appendListener(
-        eng::Event::NonChar::shift_tab, [this](char c) { select_prev_item(); });
+    select_prev_keybind_handle = keymap.add_listener(
+        eng::Event::NonChar::shift_tab, [this](char c) { select_prev_item(); },
+        this);
+
+    paste_keybind_handle = keymap.add_listener(
+        eng::Event::NonChar::paste,
+        [this, &engine](char c) { paste(engine.get_paste()); }, this);
 }
 
 void CreateUserScene::unmount(eng::Engine &engine) {
-    engine.get_eventbus().removeListener('\r', edit_item_keybind_handle);
-    engine.get_eventbus().removeListener('\t', select_next_keybind_handle);
-    engine.get_eventbus().removeListener(eng::Event::NonChar::shift_tab,
-                                         select_prev_keybind_handle);
+    if (editing) stop_editing(engine);
+
+    engine.get_keymap().remove_listener(edit_item_keybind_handle);
+    engine.get_keymap().remove_listener(select_next_keybind_handle);
+    engine.get_keymap().remove_listener(select_prev_keybind_handle);
+    engine.get_keymap().remove_listener(paste_keybind_handle);
 }
 
 void CreateUserScene::select_next_item() {
@@ -90,36 +101,60 @@ void CreateUserScene::select_prev_item() {
     }
 }
 
-void CreateUserScene::confirm(term::Transform transform,
-                              term::TermScreen &screen) {
-    switch (selected_item) {
-    case Item::username: {
-        create_data.username.clear();
-        const auto data = screen.inputline(transform.move(1, 1), 28);
-        create_data.username = data;
-    } break;
-    case Item::addr_host: {
-        create_data.addr_host.clear();
-        const auto data = screen.inputline(transform.move(1, 4), 28);
-        create_data.addr_host = data;
-    } break;
-    case Item::addr_port: {
-        create_data.addr_port.clear();
-        const auto data = screen.inputline(transform.move(1, 7), 28);
-        create_data.addr_port = data;
-    } break;
-    case Item::confirm: {
-        LOG_F(INFO, "Saving! '{}', '{}', '{}'", create_data.username,
-              create_data.addr_host, create_data.addr_port);
-
-        state->insert_new_user({-1, create_data.username, -1},
-                               {-1, create_data.addr_host,
-                                std::atoi(create_data.addr_port.c_str())});
-        create_data.reset();
-    } break;
+void CreateUserScene::paste(string_view text) {
+    if (const auto field = selected_field()) *field = field_from_paste(text);
+}
+
+void CreateUserScene::confirm(eng::Engine &engine) {
+    if (const auto field = selected_field()) {
+        LOG_F(9, "editing {}", static_cast<int>(selected_item));
+
+        editor.set_text(*field);
+        editing = true;
+        engine.grab_input([this, &engine](eng::Event e) { on_key(engine, e); });
+        return;
     }
 
+    LOG_F(INFO, "Saving! '{}', '{}', '{}'", create_data.username,
+          create_data.addr_host, create_data.addr_port);
+
+    state->insert_new_user(
+        {-1, create_data.username, -1},
+        {-1, create_data.addr_host, std::atoi(create_data.addr_port.c_str())});
+    create_data.reset();
+
     select_next_item();
-    wants_input = false;
+}
+
+void CreateUserScene::on_key(eng::Engine &engine, eng::Event e) {
+    if (e.nch == eng::Event::NonChar::esc) {
+        // Leave the input as it was
+        stop_editing(engine);
+    } else if (e.nch == eng::Event::NonChar::paste) {
+        editor.insert(field_from_paste(engine.get_paste()));
+    } else if (e.nch == eng::Event::NonChar::none &&
+               (e.ch == '\r' || e.ch == '\n' || e.ch == '\t')) {
+        *selected_field() = editor.get_text();
+        stop_editing(engine);
+        select_next_item();
+    } else {
+        editor.handle(e);
+    }
+}
+
+void CreateUserScene::stop_editing(eng::Engine &engine) {
+    editing = false;
+    engine.release_input();
+}
+
+std::string *CreateUserScene::selected_field() {
+    switch (selected_item) {
+    case Item::username: return &create_data.username;
+    case Item::addr_host: return &create_data.addr_host;
+    case Item::addr_port: return &create_data.addr_port;
+    case Item::confirm: return nullptr;
+    }
+
+    return nullptr;
 }
 } // namespace uppr::app
@@ -2,6 +2,7 @@
 
 #include "engine.hpp"
 #include "fmt/color.h"
+#include "line-edit.hpp"
 #include "scene.hpp"
 #include "state.hpp"
 #include "vector2.hpp"
@@ -62,9 +63,27 @@ private:
     void select_prev_item();
 
     /**
-     * Called when we want to save data!
+     * Called when enter is pressed: start editing the selected input, or save
+     * if the confirm button is selected.
      */
-    void confirm(term::Transform transform, term::TermScreen &screen);
+    void confirm(eng::Engine &engine);
+
+    /**
+     * Handle a key while editing an input.
+     */
+    void on_key(eng::Engine &engine, eng::Event e);
+
+    void stop_editing(eng::Engine &engine);
+
+    /**
+     * Get the data of the selected input, or `nullptr` for the button.
+     */
+    std::string *selected_field();
+
+    /**
+     * Put pasted text into the selected input.
+     */
+    void paste(string_view text);
 
 private:
     /**
@@ -75,17 +94,22 @@ private:
     /**
      * Handle for the callback for entering edit mode.
      */
-    eng::Engine::EventBus::Handle edit_item_keybind_handle;
+    eng::KeyMap::Handle edit_item_keybind_handle;
 
     /**
      * Handle for the callback for selecting the next input
      */
-    eng::Engine::EventBus::Handle select_next_keybind_handle;
+    eng::KeyMap::Handle select_next_keybind_handle;
 
     /**
      * Handle for the callback for selecting the previous input
      */
-    eng::Engine::EventBus::Handle select_prev_keybind_handle;
+    eng::KeyMap::Handle select_prev_keybind_handle;
+
+    /**
+     * Handle for the callback for pasting into the selected input.
+     */
+    eng::KeyMap::Handle paste_keybind_handle;
 
     /**
      * Data used during creation of data.
@@ -98,8 +122,13 @@ private:
     Item selected_item{Item::username};
 
     /**
-     * If the user pressed a key that says: I want to type into the field.
+     * Edits the selected input, with the same size as the box.
+     */
+    eng::LineEdit editor{28};
+
+    /**
+     * If the input is grabbed by the editor.
      */
-    bool wants_input{};
+    bool editing{};
 };
 } // namespace uppr::app
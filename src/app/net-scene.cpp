@@ -1,19 +1,21 @@
 #include "net-scene.hpp"
 #include "commom.hpp"
+#include "engine.hpp"
 #include "fmt/color.h"
 #include "message.hpp"
+#include "metrics.hpp"
 #include "msgpack/msgpack.hpp"
 #include "sockpp/sock_address.h"
 #include "sockpp/udp_socket.h"
+#include "trace.hpp"
 #include "udpmsg.hpp"
 
 #include <algorithm>
-#include <asm-generic/socket.h>
-#include <bits/types/struct_timeval.h>
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <fmt/ranges.h>
+#include <poll.h>
 #include <string>
 #include <thread>
 
@@ -61,8 +63,20 @@ void NetScene::draw(eng::Engine &engine, term::Transform transform,
                     term::Size size, term::TermScreen &screen) {
     using namespace fmt;
 
-    screen.print(transform.move(0, size.gety() - 2), emphasis::reverse, "{}",
-                 state->get_outbound_message_list().size());
+    drawn_outbound = state->get_outbound_message_list().size();
+    screen.canvas(transform, size)
+        .print(0, static_cast<int>(size.gety()) - 2, emphasis::reverse, "{}",
+               drawn_outbound);
+}
+
+void NetScene::damage(term::Rect area, term::TermScreen &screen) {
+    if (drawn_outbound == damaged_outbound) return;
+
+    // Wide enough for any count, so that a shorter one clears the old one
+    const term::Rect counter{area.tl.move(0, area.size.gety() - 2), {20, 1}};
+    screen.damage(counter.intersect(area));
+
+    damaged_outbound = drawn_outbound;
 }
 
 void NetScene::mount(eng::Engine &engine) {
@@ -71,36 +85,43 @@ void NetScene::mount(eng::Engine &engine) {
 
     LOG_F(INFO, "Got listening port {}", port);
 
-    listener_alive = true;
+    // Have the engine pick up messages as soon as they arrive or are sent
+    const auto waker = engine.get_waker();
+    state->set_waker(waker);
+
+    listener = std::thread{[this, port, waker] {
+        trace::set_thread_name("net listener");
 
-    listener = std::thread{[this, port] {
         sockpp::inet_address addr{"0.0.0.0", static_cast<in_port_t>(port)};
         sockpp::inet_address recv_addr;
 
         sockpp::udp_socket sock;
 
-        struct timeval tv;
-        tv.tv_usec = 100'000; // 100ms
-        sock.set_option(SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
         if (!sock.bind(addr)) {
             LOG_F(ERROR, "Error binding receiving socket");
             return;
         }
 
         std::vector<uint8_t> buf;
-        buf.resize(64);
+        buf.resize(models::UdpMessage::max_wire_size);
 
-        while (listener_alive) {
+        while (true) {
+            // Sleep until there is a message or we are told to stop
+            std::array<pollfd, 2> fds{{
+                {.fd = sock.handle(), .events = POLLIN},
+                {.fd = stop_listener.get_fd(), .events = POLLIN},
+            }};
+            if (poll(fds.data(), fds.size(), -1) < 0) continue;
+            if (fds[1].revents & POLLIN) break;
 
             try {
+                const trace::Span span{"recv_from", "net"};
+
                 const auto n =
                     sock.recv_from(buf.data(), buf.size(), &recv_addr);
-                if (n <= 0) {
-                    // timeout should be ignored
-                    // LOG_F(INFO, "n <= 0 = {}", n);
-                    continue;
-                }
+                if (n <= 0) continue;
+
+                metrics::datagrams_received.add();
 
                 LOG_F(7, "Got message data ({} bytes) from {}: {}", n,
                       recv_addr.to_string(), buf);
@@ -116,6 +137,7 @@ void NetScene::mount(eng::Engine &engine) {
                 LOG_F(4, "Got message: {}, {}", message.content, message.sent_by);
 
                 inbound_messages.enqueue(message);
+                waker.wake();
             } catch (const std::exception &e) {
                 LOG_F(ERROR, "Error receiving message: '{}'", e.what());
             }
@@ -126,7 +148,10 @@ void NetScene::mount(eng::Engine &engine) {
 void NetScene::unmount(eng::Engine &engine) { join_listener(); }
 
 void NetScene::join_listener() {
-    listener_alive = false;
-    if (listener.joinable()) listener.join();
+    if (!listener.joinable()) return;
+
+    stop_listener.signal();
+    listener.join();
+    stop_listener.drain();
 }
 } // namespace uppr::app
@@ -2,6 +2,7 @@
 
 #include "eventpp/eventqueue.h"
 #include "message.hpp"
+#include "reactor.hpp"
 #include "safe-queue.hpp"
 #include "scene.hpp"
 #include "state.hpp"
@@ -20,10 +21,17 @@ public:
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
     void mount(eng::Engine &engine) override;
 
     void unmount(eng::Engine &engine) override;
 
+    /**
+     * Get how many received messages are waiting for the next update.
+     */
+    usize get_inbound_depth() { return inbound_messages.size(); }
+
     static std::shared_ptr<NetScene> make(shared_ptr<AppState> s) {
         return std::make_shared<NetScene>(s);
     }
@@ -34,8 +42,20 @@ private:
 private:
     shared_ptr<AppState> state;
     std::thread listener;
-    std::atomic<bool> listener_alive;
+
+    /**
+     * Signaled to stop the listener, which otherwise blocks until a message
+     * arrives.
+     */
+    os::EventFd stop_listener;
 
     SafeQueue<models::UdpMessage> inbound_messages;
+
+    /**
+     * The count of outbound messages that was drawn, and the one that was
+     * drawn when we last said that it changed.
+     */
+    usize drawn_outbound{};
+    usize damaged_outbound{~0UL};
 };
 } // namespace uppr::app
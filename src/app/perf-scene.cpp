@@ -0,0 +1,270 @@
+#include "perf-scene.hpp"
+#include "fmt/color.h"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace uppr::app {
+
+namespace {
+
+constexpr usize label_width = 16;
+
+/**
+ * Width of each of the statistics columns, and how many there are.
+ */
+constexpr usize stat_width = 9;
+constexpr usize stat_count = 4;
+
+/**
+ * Format into `buf`, cutting what does not fit.
+ */
+template <usize N, typename... Args>
+string_view format_into(array<char, N> &buf, fmt::format_string<Args...> fmt,
+                        Args &&...args) {
+    const auto r = fmt::format_to_n(buf.data(), buf.size(), fmt,
+                                    std::forward<Args>(args)...);
+    return {buf.data(), std::min(r.size, buf.size())};
+}
+} // namespace
+
+PerfScene::PerfScene(shared_ptr<AppState> s, shared_ptr<NetScene> n)
+    : state{s}, net{n}, last_second{std::chrono::steady_clock::now()} {
+    series[fps] = {"fps", Unit::count};
+    series[frame] = {"frame", Unit::micros};
+    series[update_phase] = {"update", Unit::micros};
+    series[draw_phase] = {"draw", Unit::micros};
+    series[commit] = {"commit", Unit::micros};
+    series[output] = {"output", Unit::bytes};
+    series[db_queries] = {"db queries", Unit::per_second};
+    series[datagrams_in] = {"datagrams in", Unit::per_second};
+    series[datagrams_out] = {"datagrams out", Unit::per_second};
+    series[inbound_depth] = {"inbound queue", Unit::count};
+    series[outbound_depth] = {"outbound queue", Unit::count};
+    series[memory] = {"resident memory", Unit::bytes};
+
+    last_queries = metrics::db_queries.get();
+    last_datagrams_in = metrics::datagrams_received.get();
+    last_datagrams_out = metrics::datagrams_sent.get();
+}
+
+void PerfScene::update(eng::Engine &engine) {
+    sample_frame(engine);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_second >= std::chrono::seconds{1}) sample_second(now);
+}
+
+void PerfScene::sample_frame(eng::Engine &engine) {
+    series[fps].add(engine.get_scheduler().get_fps(
+        std::chrono::steady_clock::now()));
+
+    // These are all about the last frame, this one is not done yet
+    series[frame].add(engine.get_frame_time());
+    series[update_phase].add(engine.get_update_time());
+    series[draw_phase].add(engine.get_draw_time());
+    series[commit].add(engine.get_commit_time());
+
+    const auto bytes = engine.get_output_stats().bytes;
+    series[output].add(bytes - last_output_bytes);
+    last_output_bytes = bytes;
+
+    sampled_frames++;
+}
+
+void PerfScene::sample_second(std::chrono::steady_clock::time_point now) {
+    const auto elapsed =
+        std::chrono::duration<float>(now - last_second).count();
+    last_second = now;
+
+    const auto rate = [&](u64 count, u64 &last) {
+        const auto r = (count - last) / elapsed;
+        last = count;
+        return r;
+    };
+
+    series[db_queries].add(rate(metrics::db_queries.get(), last_queries));
+    series[datagrams_in].add(
+        rate(metrics::datagrams_received.get(), last_datagrams_in));
+    series[datagrams_out].add(
+        rate(metrics::datagrams_sent.get(), last_datagrams_out));
+
+    series[inbound_depth].add(net->get_inbound_depth());
+
+    usize outbound{};
+    for (const auto &list : state->get_outbound_message_list())
+        outbound += list.size();
+    series[outbound_depth].add(outbound);
+
+    series[memory].add(metrics::resident_memory());
+}
+
+string_view PerfScene::format_value(Unit unit, double value,
+                                     array<char, 16> &buf) {
+    switch (unit) {
+    case Unit::micros:
+        if (value < 1000) return format_into(buf, "{:.0f}us", value);
+        return format_into(buf, "{:.1f}ms", value / 1e3);
+    case Unit::bytes:
+        if (value < 1024) return format_into(buf, "{:.0f}B", value);
+        if (value < 1024 * 1024)
+            return format_into(buf, "{:.1f}K", value / 1024);
+        return format_into(buf, "{:.1f}M", value / (1024 * 1024));
+    case Unit::per_second:
+        if (value < 10) return format_into(buf, "{:.1f}/s", value);
+        return format_into(buf, "{:.0f}/s", value);
+    case Unit::count: return format_into(buf, "{:.0f}", value);
+    }
+
+    return {};
+}
+
+void PerfScene::draw(eng::Engine &engine, term::Transform transform,
+                     term::Size size, term::TermScreen &screen) {
+    using namespace fmt;
+
+    if (!showing) return;
+
+    drawn_frames = sampled_frames;
+
+    // Cover whatever is below
+    const auto [w, h] = size;
+    for (usize y{}; y < h; y++)
+        screen.hline(transform.getx(), transform.getx() + w,
+                     transform.gety() + y, {});
+
+    auto &scheduler = engine.get_scheduler();
+    screen.print(transform.move(1, 0), emphasis::reverse, " Performance ");
+    screen.print(transform.move(15, 0), emphasis::faint,
+                 "F2 to close, +/- for FPS: {} at most, {} idle, budget {}us, "
+                 "{} draws skipped",
+                 scheduler.get_max_fps(), scheduler.get_idle_fps(),
+                 engine.get_max_frame_time(), metrics::frames_skipped.get());
+
+    const auto stats_width = stat_width * stat_count;
+    if (w < label_width + stats_width + 2) return;
+
+    const auto spark_width =
+        std::min(history, w - label_width - stats_width - 2);
+    const auto stats_x = static_cast<int>(label_width + spark_width + 2);
+
+    auto t = transform.move(1, 2);
+    const auto heading = [&](string_view title) {
+        screen.print(t, emphasis::bold, "{}", title);
+        screen.print(t.move(stats_x - 1, 0), emphasis::bold,
+                     "{:>9}{:>9}{:>9}{:>9}", "last", "p50", "p99", "max");
+        t += {0, 1};
+    };
+
+    heading("Every frame");
+    for (usize i{}; i < first_per_second; i++) {
+        draw_series(series[i], t, spark_width, screen);
+        t += {0, 1};
+    }
+
+    t += {0, 1};
+    heading("Every second");
+    for (usize i = first_per_second; i < series_count; i++) {
+        draw_series(series[i], t, spark_width, screen);
+        t += {0, 1};
+    }
+}
+
+void PerfScene::draw_series(const Series &s, term::Transform transform,
+                            usize spark_width, term::TermScreen &screen) {
+    using namespace fmt;
+
+    screen.print(transform, "{}", s.label);
+
+    const auto n = s.size();
+    if (n == 0) return;
+
+    // Statistics over every sample that is kept
+    array<float, history> sorted;
+    for (usize i{}; i < n; i++) sorted[i] = s.get(n, i);
+    std::sort(sorted.begin(), sorted.begin() + n);
+
+    const auto percentile = [&](double p) {
+        return sorted[std::min(n - 1, static_cast<usize>(p * n))];
+    };
+
+    // The sparkline only has the newest ones, scaled to the biggest of them
+    const auto shown = std::min(n, spark_width);
+    float peak{};
+    for (usize i{}; i < shown; i++) peak = std::max(peak, s.get(shown, i));
+
+    const term::PackedStyle spark_style{fg(color::green)};
+    auto x = transform.move(label_width, 0);
+    for (usize i{}; i < shown; i++, x += {1, 0}) {
+        const auto v = s.get(shown, i);
+        if (v <= 0 || peak <= 0) continue;
+
+        const auto level =
+            std::clamp(static_cast<int>(std::ceil(v / peak * 8)), 1, 8);
+        const auto glyph = static_cast<char32_t>(U'▁' + level - 1);
+        screen.setc(x, {glyph, spark_style});
+    }
+
+    array<char, 16> buf;
+    auto stat = transform.move(label_width + spark_width + 1, 0);
+    for (const auto v : {s.get(1, 0), percentile(0.5), percentile(0.99),
+                         sorted[n - 1]}) {
+        screen.print(stat, "{:>9}", format_value(s.unit, v, buf));
+        stat += {stat_width, 0};
+    }
+}
+
+void PerfScene::damage(term::Rect area, term::TermScreen &screen) {
+    // Showing or hiding changes everything, and while shown every new sample
+    // moves the sparklines
+    if (showing != damaged_showing ||
+        (showing && drawn_frames != damaged_frames)) {
+        screen.damage(area);
+        damaged_showing = showing;
+        damaged_frames = drawn_frames;
+    }
+}
+
+void PerfScene::mount(eng::Engine &engine) {
+    // Not owned by this scene, so that it works while another one has the
+    // focus
+    toggle_handle = engine.get_keymap().add_listener(
+        eng::Event::NonChar::f2, [this, &engine](char) { toggle(engine); });
+
+    // Owned, so that no one else gets them while shown (and they do nothing
+    // while hidden)
+    faster_handle = engine.get_keymap().add_listener(
+        '+', [this, &engine](char) { change_fps(engine, 5); }, this);
+    slower_handle = engine.get_keymap().add_listener(
+        '-', [this, &engine](char) { change_fps(engine, -5); }, this);
+}
+
+void PerfScene::unmount(eng::Engine &engine) {
+    if (showing) toggle(engine);
+
+    engine.get_keymap().remove_listener(toggle_handle);
+    engine.get_keymap().remove_listener(faster_handle);
+    engine.get_keymap().remove_listener(slower_handle);
+}
+
+void PerfScene::toggle(eng::Engine &engine) {
+    showing = !showing;
+
+    // While shown, it takes the keys and keeps the rates going
+    if (showing) {
+        engine.get_keymap().push_focus(this);
+        engine.set_animation_period(std::chrono::seconds{1});
+    } else {
+        engine.get_keymap().pop_focus(this);
+        engine.set_animation_period({});
+    }
+}
+
+void PerfScene::change_fps(eng::Engine &engine, int delta) {
+    if (!showing) return;
+
+    auto &scheduler = engine.get_scheduler();
+    scheduler.set_max_fps(std::max(scheduler.get_max_fps() + delta, 5));
+}
+} // namespace uppr::app
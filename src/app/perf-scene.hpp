@@ -2,52 +2,165 @@
 
 #include "eng/engine.hpp"
 #include "eng/scene.hpp"
-#include "key.hpp"
+#include "key-map.hpp"
+#include "net-scene.hpp"
+#include "state.hpp"
 #include "vector2.hpp"
 
+#include <chrono>
+
 namespace uppr::app {
 
 /**
- * This scene simply show performance information at the top-right edge of the
- * parent scene.
+ * A dashboard of how the app is performing, that covers the whole screen.
+ * F2 shows and hides it, and while it is shown the keys of the other scenes
+ * are ignored, and + and - change the most FPS of the engine.
+ *
+ * Samples are taken all the time, even when hidden, so that there is already
+ * a history when it is shown: the rate that the scheduler was at, the times
+ * of each frame and the bytes that it wrote to the terminal on every frame,
+ * and rates, queue depths and memory once per second. Each is kept in a ring
+ * of the last `history` samples, and drawn as a sparkline next to its
+ * percentiles. While shown, a frame is run every second, to keep the rates
+ * going when nothing else is happening.
  */
 class PerfScene : public eng::Scene {
 public:
-    void update(eng::Engine &engine) override {}
+    /**
+     * How many samples are kept of each series.
+     */
+    static constexpr usize history = 120;
+
+    PerfScene(shared_ptr<AppState> s, shared_ptr<NetScene> n);
+
+    void update(eng::Engine &engine) override;
 
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
-              term::TermScreen &screen) override {
-        using namespace fmt;
-
-        /*
-        const auto max_frame = engine.get_max_frame_time();
-        const auto frame = engine.get_frame_time();
-        const auto update = engine.get_update_time();
-        const auto draw = engine.get_draw_time();
-        const auto commit = engine.get_commit_time();
-
-        const auto percent = [&](double time) {
-            return (time / max_frame) * 100;
-        };
-
-        const auto pframe = percent(frame);
-        const auto pupdate = percent(update);
-        const auto pdraw = percent(draw);
-        const auto pcommit = percent(commit);
-
-        screen.print(transform.move(size.getx() - 60, 0),
-                     "{:05d}/{:05d}us ({:0.2f}%, {:0.2f}%, {:0.2f}%, {:0.2f}%)",
-                     frame, max_frame, pframe, pupdate, pdraw, pcommit);
-                     */
-    }
+              term::TermScreen &screen) override;
+
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
+    void mount(eng::Engine &engine) override;
+
+    void unmount(eng::Engine &engine) override;
 
     /**
      * Create an instance of this scene as a `shared_ptr`.
      */
-    static shared_ptr<PerfScene> make() {
-        return std::make_shared<PerfScene>();
+    static shared_ptr<PerfScene> make(shared_ptr<AppState> s,
+                                      shared_ptr<NetScene> n) {
+        return std::make_shared<PerfScene>(s, n);
     }
 
 private:
+    /**
+     * How the values of a series are shown.
+     */
+    enum class Unit { micros, bytes, per_second, count };
+
+    /**
+     * The last `history` samples of something, as a ring.
+     */
+    struct Series {
+        const char *label{};
+        Unit unit{};
+
+        array<float, history> samples{};
+
+        /**
+         * How many samples were ever added, the last one is at `(count - 1)
+         * % history`.
+         */
+        usize count{};
+
+        void add(float value) { samples[count++ % history] = value; }
+
+        /**
+         * Get the `i`th of the last `n` samples, oldest first.
+         */
+        float get(usize n, usize i) const {
+            return samples[(count - n + i) % history];
+        }
+
+        usize size() const { return std::min(count, history); }
+    };
+
+    enum SeriesId {
+        fps,
+        frame,
+        update_phase,
+        draw_phase,
+        commit,
+        output,
+        db_queries,
+        datagrams_in,
+        datagrams_out,
+        inbound_depth,
+        outbound_depth,
+        memory,
+        series_count,
+    };
+
+    /**
+     * The ones that come before this are sampled every frame.
+     */
+    static constexpr usize first_per_second = db_queries;
+
+    void toggle(eng::Engine &engine);
+
+    /**
+     * Change the most FPS of the engine by `delta`.
+     */
+    void change_fps(eng::Engine &engine, int delta);
+
+    void sample_frame(eng::Engine &engine);
+
+    void sample_second(std::chrono::steady_clock::time_point now);
+
+    /**
+     * Format a value of a series for the statistics columns, into `buf`.
+     */
+    static string_view format_value(Unit unit, double value,
+                                    array<char, 16> &buf);
+
+    /**
+     * Draw a row with the sparkline and the statistics of a series.
+     */
+    void draw_series(const Series &s, term::Transform transform,
+                     usize spark_width, term::TermScreen &screen);
+
+private:
+    shared_ptr<AppState> state;
+    shared_ptr<NetScene> net;
+
+    array<Series, series_count> series;
+
+    /**
+     * Counters at the last time that the per second series were sampled, to
+     * get rates from.
+     */
+    std::chrono::steady_clock::time_point last_second;
+    u64 last_queries{};
+    u64 last_datagrams_in{};
+    u64 last_datagrams_out{};
+
+    /**
+     * Bytes written to the terminal when the last frame was sampled.
+     */
+    usize last_output_bytes{};
+
+    bool showing{};
+
+    /**
+     * What was drawn, to only damage the screen when it changed.
+     */
+    usize sampled_frames{};
+    usize drawn_frames{};
+    usize damaged_frames{~0UL};
+    bool damaged_showing{};
+
+    eng::KeyMap::Handle toggle_handle;
+    eng::KeyMap::Handle faster_handle;
+    eng::KeyMap::Handle slower_handle;
 };
 } // namespace uppr::app
@@ -38,22 +38,27 @@ void RemoveUserFromChatScene::mount(eng::Engine &engine) {
 
     update_users();
 
-    select_next_keybind_handle =
-        engine.get_eventbus().appendListener('\r', [this](char c) {
+    auto &keymap = engine.get_keymap();
+
+    confirm_keybind_handle = keymap.add_listener(
+        '\r',
+        [this](char c) {
             if (has_user_available) confirm();
-        });
+        },
+        this);
 
-    select_next_keybind_handle = engine.get_eventbus().appendListener(
-        '\t', [this](char c) { select_next_user(); });
+    select_next_keybind_handle = keymap.add_listener(
+        '\t', [this](char c) { select_next_user(); }, this);
 
-    select_prev_keybind_handle = engine.get_eventbus().appendListener(
-        eng::Event::NonChar::shift_tab, [this](char c) { select_prev_user(); });
+    select_prev_keybind_handle = keymap.add_listener(
+        eng::Event::NonChar::shift_tab, [this](char c) { select_prev_user(); },
+        this);
 }
 
 void RemoveUserFromChatScene::unmount(eng::Engine &engine) {
-    engine.get_eventbus().removeListener('\t', select_next_keybind_handle);
-    engine.get_eventbus().removeListener(eng::Event::NonChar::shift_tab,
-                                         select_prev_keybind_handle);
+    engine.get_keymap().remove_listener(confirm_keybind_handle);
+    engine.get_keymap().remove_listener(select_next_keybind_handle);
+    engine.get_keymap().remove_listener(select_prev_keybind_handle);
 }
 
 void RemoveUserFromChatScene::update_users() {
@@ -60,15 +60,20 @@ private:
      */
     std::vector<std::pair<models::UserModel, bool>> users;
 
+    /**
+     * Handle for the callback for confirming the selected user.
+     */
+    eng::KeyMap::Handle confirm_keybind_handle;
+
     /**
      * Handle for the callback for selecting the next input
      */
-    eng::Engine::EventBus::Handle select_next_keybind_handle;
+    eng::KeyMap::Handle select_next_keybind_handle;
 
     /**
      * Handle for the callback for selecting the previous input
      */
-    eng::Engine::EventBus::Handle select_prev_keybind_handle;
+    eng::KeyMap::Handle select_prev_keybind_handle;
 
     /**
      * The currently selected input item.
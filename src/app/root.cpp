@@ -30,7 +30,8 @@ shared_ptr<eng::Scene> make_scene_tree(eng::Engine &engine,
     const auto stack = eng::StackScene::make();
 
     stack->add_scene(engine, SidebarScene::make(ChatScene::make(state), state));
-    stack->add_scene(engine, NetScene::make(state));
+    const auto net = NetScene::make(state);
+    stack->add_scene(engine, net);
 
     // The main show
     {
@@ -52,13 +53,14 @@ shared_ptr<eng::Scene> make_scene_tree(eng::Engine &engine,
                              add_usertochat_modal, remove_userfromchat_modal));
     }
 
-    // The performance scene to shows performance stats
-    stack->add_scene(engine, PerfScene::make());
+    // The performance dashboard, on top of everything when shown
+    stack->add_scene(engine, PerfScene::make(state, net));
 
     return stack;
 }
 
-int start_app(shared_ptr<term::TermScreen> term_screen, int port, const std::string& name) {
+int start_app(shared_ptr<term::TermScreen> term_screen, int port,
+              const std::string &name, int max_fps, int idle_fps) {
     // Initialize the database connection
     const auto database_connection = uppr::except::wrap_fatal_exception([] {
         const auto source = file::read_file_text("res/tables-safe.sql");
@@ -76,7 +78,8 @@ int start_app(shared_ptr<term::TermScreen> term_screen, int port, const std::str
 
     // Create our engine with FPS, screen and root scene (which we will insert
     // later)
-    eng::Engine engine{30, term_screen, nullptr};
+    eng::Engine engine{max_fps, term_screen, nullptr};
+    engine.get_scheduler().set_idle_fps(idle_fps);
 
     // Create our scene tree and add it to the engine
     const auto root_scene = make_scene_tree(engine, app_state);
@@ -6,6 +6,10 @@ namespace uppr::app {
 
 /**
  * Launch the app!
+ *
+ * Frames run at up to `max_fps` while there is input or traffic, and slow
+ * down to `idle_fps` when there is not (see `eng::FrameScheduler`).
  */
-int start_app(shared_ptr<term::TermScreen> term_screen, int port, const std::string& name);
+int start_app(shared_ptr<term::TermScreen> term_screen, int port,
+              const std::string &name, int max_fps, int idle_fps);
 } // namespace uppr::app
@@ -6,20 +6,52 @@
 namespace uppr::app {
 
 void SelectViewScene::update(eng::Engine &engine) {
-    create_user_modal->update(engine);
-    create_chat_modal->update(engine);
-    add_user_to_chat_modal->update(engine);
-    remove_user_from_chat_modal->update(engine);
+    create_user_modal->run_update(engine);
+    create_chat_modal->run_update(engine);
+    add_user_to_chat_modal->run_update(engine);
+    remove_user_from_chat_modal->run_update(engine);
 }
 
 void SelectViewScene::draw(eng::Engine &engine, term::Transform transform,
                            term::Size size, term::TermScreen &screen) {
-    create_user_modal->draw(engine, transform, size, screen);
-    create_chat_modal->draw(engine, transform, size, screen);
-    add_user_to_chat_modal->draw(engine, transform, size, screen);
-    remove_user_from_chat_modal->draw(engine, transform, size, screen);
+    create_user_modal->run_draw(engine, transform, size, screen);
+    create_chat_modal->run_draw(engine, transform, size, screen);
+    add_user_to_chat_modal->run_draw(engine, transform, size, screen);
+    remove_user_from_chat_modal->run_draw(engine, transform, size, screen);
+
+    // The bottom panel only changes when a chat gets (de)selected, so keep it
+    // in a layer and draw it again only then
+    const term::Transform panel_tl{transform.getx(),
+                                   transform.gety() +
+                                       static_cast<int>(size.gety()) - 1};
+    const term::Size panel_size{size.getx(), 1};
+    const int panel_key = state->has_chat_selected();
+
+    if (panel_key != bottom_panel_key ||
+        panel_tl != bottom_panel_layer.get_origin() ||
+        panel_size != bottom_panel_layer.get_size()) {
+        screen.push_layer(bottom_panel_layer, panel_tl, panel_size);
+        draw_bottom_panel(engine, transform, size, screen);
+        screen.pop_layer();
+
+        bottom_panel_key = panel_key;
+        bottom_panel_redrawn = true;
+    }
+
+    screen.blit(bottom_panel_layer);
+}
 
-    draw_bottom_panel(engine, transform, size, screen);
+void SelectViewScene::damage(term::Rect area, term::TermScreen &screen) {
+    create_user_modal->damage(area, screen);
+    create_chat_modal->damage(area, screen);
+    add_user_to_chat_modal->damage(area, screen);
+    remove_user_from_chat_modal->damage(area, screen);
+
+    if (bottom_panel_redrawn) {
+        screen.damage({bottom_panel_layer.get_origin(),
+                       bottom_panel_layer.get_size()});
+        bottom_panel_redrawn = false;
+    }
 }
 
 void SelectViewScene::mount(eng::Engine &engine) {
@@ -55,21 +87,25 @@ void SelectViewScene::mount(eng::Engine &engine) {
         add_removeuser_close_handler(engine);
     };
 
-    // Event handler for the `ctrl+n` key
-    open_create_user_keybind_handle = engine.get_eventbus().appendListener(
-        term::ctrl('u'), open_user_listener);
-    open_create_chat_keybind_handle = engine.get_eventbus().appendListener(
-        term::ctrl('c'), open_chat_listener);
-    open_create_chat_keybind_handle = engine.get_eventbus().appendListener(
-        term::ctrl('a'), open_adduser_listener);
+    auto &keymap = engine.get_keymap();
+
+    // These are skipped while a modal has the focus
+    open_create_user_keybind_handle =
+        keymap.add_listener(term::ctrl('u'), open_user_listener, this);
+    open_create_chat_keybind_handle =
+        keymap.add_listener(term::ctrl('c'), open_chat_listener, this);
+    open_add_user_to_chat_keybind_handle =
+        keymap.add_listener(term::ctrl('a'), open_adduser_listener, this);
     open_remove_user_from_chat_keybind_handle =
-        engine.get_eventbus().appendListener(term::ctrl('d'),
-                                             open_removeuser_listener);
+        keymap.add_listener(term::ctrl('d'), open_removeuser_listener, this);
 }
 
 void SelectViewScene::unmount(eng::Engine &engine) {
-    engine.get_eventbus().removeListener(term::ctrl('u'),
-                                         open_create_user_keybind_handle);
+    auto &keymap = engine.get_keymap();
+    keymap.remove_listener(open_create_user_keybind_handle);
+    keymap.remove_listener(open_create_chat_keybind_handle);
+    keymap.remove_listener(open_add_user_to_chat_keybind_handle);
+    keymap.remove_listener(open_remove_user_from_chat_keybind_handle);
 
     if (close_any_modal_keybind_handle) remove_close_handler(engine);
 }
@@ -80,23 +116,28 @@ void SelectViewScene::draw_bottom_panel(eng::Engine &engine,
                                         term::TermScreen &screen) const {
     using namespace fmt;
 
-    transform += {0, static_cast<int>(size.gety() - 1)};
+    // A single line at the bottom
+    auto canvas = screen.canvas(
+        transform.move(0, static_cast<int>(size.gety() - 1)),
+        {size.getx(), 1});
 
     const auto style = bg(color::dark_gray) | fg(color::black);
+    const term::PackedStyle packed{style};
 
-    screen.hline(0, size.getx(), transform.gety(), {' ', style});
+    canvas.fill({{}, canvas.get_size()}, {U' ', packed});
+    int x{};
 
     constexpr auto exit_help = "<ctrl+q> EXIT |"sv;
-    screen.print(transform, style, exit_help);
-    transform += {1 + exit_help.size(), 0};
+    canvas.glyphs(x, 0, exit_help, packed);
+    x += 1 + exit_help.size();
 
     constexpr auto create_user_help = "<ctrl+u> Create User |"sv;
-    screen.print(transform, style, create_user_help);
-    transform += {1 + create_user_help.size(), 0};
+    canvas.glyphs(x, 0, create_user_help, packed);
+    x += 1 + create_user_help.size();
 
     constexpr auto create_chat_help = "<ctrl+c> Create Chat |"sv;
-    screen.print(transform, style, create_chat_help);
-    transform += {1 + create_chat_help.size(), 0};
+    canvas.glyphs(x, 0, create_chat_help, packed);
+    x += 1 + create_chat_help.size();
 
     if (state->has_chat_selected()) {
         /*
@@ -110,8 +151,8 @@ void SelectViewScene::draw_bottom_panel(eng::Engine &engine,
         */
 
         constexpr auto message_help = "<m> Write |"sv;
-        screen.print(transform, style, message_help);
-        transform += {1 + message_help.size(), 0};
+        canvas.glyphs(x, 0, message_help, packed);
+        x += 1 + message_help.size();
     }
 }
 
@@ -120,7 +161,7 @@ void SelectViewScene::add_user_close_handler(eng::Engine &engine) {
     if (close_any_modal_keybind_handle) remove_close_handler(engine);
 
     // When <ESC> is pressed, we close the create user modal
-    close_any_modal_keybind_handle = engine.get_eventbus().appendListener(
+    close_any_modal_keybind_handle = engine.get_keymap().add_listener(
         eng::Event::NonChar::esc, [this, &engine](char c) {
             LOG_F(8, "closing create user");
 
@@ -134,7 +175,7 @@ void SelectViewScene::add_chat_close_handler(eng::Engine &engine) {
     if (close_any_modal_keybind_handle) remove_close_handler(engine);
 
     // When <ESC> is pressed, we close the create user modal
-    close_any_modal_keybind_handle = engine.get_eventbus().appendListener(
+    close_any_modal_keybind_handle = engine.get_keymap().add_listener(
         eng::Event::NonChar::esc, [this, &engine](char c) {
             LOG_F(8, "closing create chat");
 
@@ -148,7 +189,7 @@ void SelectViewScene::add_adduser_close_handler(eng::Engine &engine) {
     if (close_any_modal_keybind_handle) remove_close_handler(engine);
 
     // When <ESC> is pressed, we close the add user modal
-    close_any_modal_keybind_handle = engine.get_eventbus().appendListener(
+    close_any_modal_keybind_handle = engine.get_keymap().add_listener(
         eng::Event::NonChar::esc, [this, &engine](char c) {
             LOG_F(8, "closing add user to chat");
 
@@ -162,18 +203,16 @@ void SelectViewScene::add_removeuser_close_handler(eng::Engine &engine) {
     if (close_any_modal_keybind_handle) remove_close_handler(engine);
 
     // When <ESC> is pressed, we close the remove user modal
-    open_remove_user_from_chat_keybind_handle =
-        engine.get_eventbus().appendListener(
-            eng::Event::NonChar::esc, [this, &engine](char c) {
-                LOG_F(8, "closing remove user from chat");
+    close_any_modal_keybind_handle = engine.get_keymap().add_listener(
+        eng::Event::NonChar::esc, [this, &engine](char c) {
+            LOG_F(8, "closing remove user from chat");
 
-                remove_user_from_chat_modal->hide_modal(engine);
-                remove_close_handler(engine);
-            });
+            remove_user_from_chat_modal->hide_modal(engine);
+            remove_close_handler(engine);
+        });
 }
 
 void SelectViewScene::remove_close_handler(eng::Engine &engine) {
-    engine.get_eventbus().removeListener(eng::Event::NonChar::esc,
-                                         close_any_modal_keybind_handle);
+    engine.get_keymap().remove_listener(close_any_modal_keybind_handle);
 }
 } // namespace uppr::app
@@ -25,6 +25,8 @@ public:
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
     void mount(eng::Engine &engine) override;
 
     void unmount(eng::Engine &engine) override;
@@ -88,10 +90,26 @@ private:
     shared_ptr<eng::ModalScene> add_user_to_chat_modal;
     shared_ptr<eng::ModalScene> remove_user_from_chat_modal;
 
-    eng::Engine::EventBus::Handle open_create_user_keybind_handle;
-    eng::Engine::EventBus::Handle open_create_chat_keybind_handle;
-    eng::Engine::EventBus::Handle open_add_user_to_chat_keybind_handle;
-    eng::Engine::EventBus::Handle open_remove_user_from_chat_keybind_handle;
-    eng::Engine::EventBus::Handle close_any_modal_keybind_handle;
+    eng::KeyMap::Handle open_create_user_keybind_handle;
+    eng::KeyMap::Handle open_create_chat_keybind_handle;
+    eng::KeyMap::Handle open_add_user_to_chat_keybind_handle;
+    eng::KeyMap::Handle open_remove_user_from_chat_keybind_handle;
+    eng::KeyMap::Handle close_any_modal_keybind_handle;
+
+    /**
+     * What `draw_bottom_panel` drew last time.
+     */
+    term::Surface bottom_panel_layer;
+
+    /**
+     * If a chat was selected when the bottom panel was drawn (or -1 if it
+     * was never drawn).
+     */
+    int bottom_panel_key{-1};
+
+    /**
+     * If `bottom_panel_layer` was drawn again since the last `damage()`.
+     */
+    bool bottom_panel_redrawn{};
 };
 } // namespace uppr::app
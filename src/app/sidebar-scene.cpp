@@ -3,8 +3,8 @@
 namespace uppr::app {
 
 void SidebarScene::update(eng::Engine &engine) {
-    chatview->update(engine);
-    content->update(engine);
+    chatview->run_update(engine);
+    content->run_update(engine);
 }
 
 void SidebarScene::draw(eng::Engine &engine, term::Transform transform,
@@ -14,19 +14,41 @@ void SidebarScene::draw(eng::Engine &engine, term::Transform transform,
     // The sidebar has the size of 1/3 of the screen width
     const auto width = show_sidebar ? size.getx() / 3 : 0;
     if (show_sidebar) {
-        chatview->draw(engine, transform, {width, size.gety()}, screen);
+        chatview->run_draw(engine, transform, {width, size.gety()}, screen);
 
-        screen.vline(width, 0, size.gety(), '|');
+        screen.canvas(transform, size).vline(width, 0, size.gety(), '|');
     }
 
     const auto csize = size - term::Size{width + show_sidebar, 0};
-    content->draw(engine, transform.move(width + show_sidebar, 0), csize,
-                  screen);
+    content->run_draw(engine, transform.move(width + show_sidebar, 0), csize,
+                      screen);
+}
+
+void SidebarScene::damage(term::Rect area, term::TermScreen &screen) {
+    // Hiding, showing or moving the sidebar moves everything around
+    if (area != damaged_area || show_sidebar != damaged_show_sidebar) {
+        screen.damage(area);
+
+        damaged_area = area;
+        damaged_show_sidebar = show_sidebar;
+    }
+
+    const auto width = show_sidebar ? area.size.getx() / 3 : 0;
+    if (show_sidebar)
+        chatview->damage(term::Rect{area.tl, {width, area.size.gety()}}
+                             .intersect(area),
+                         screen);
+
+    const term::Rect content_area{
+        area.tl.move(width + show_sidebar, 0),
+        area.size - term::Size{width + show_sidebar, 0}};
+    content->damage(content_area.intersect(area), screen);
 }
 
 void SidebarScene::mount(eng::Engine &engine) {
-    hide_sidebar_keybind_handle = engine.get_eventbus().appendListener(
-        term::ctrl('e'), [this](char c) { show_sidebar = !show_sidebar; });
+    hide_sidebar_keybind_handle = engine.get_keymap().add_listener(
+        term::ctrl('e'), [this](char c) { show_sidebar = !show_sidebar; },
+        this);
 
     chatview->mount(engine);
     content->mount(engine);
@@ -34,8 +56,7 @@ void SidebarScene::mount(eng::Engine &engine) {
 
 void SidebarScene::unmount(eng::Engine &engine) {
     // Remove the event handler for the `ctrl+n` key
-    engine.get_eventbus().removeListener(term::ctrl('e'),
-                                         hide_sidebar_keybind_handle);
+    engine.get_keymap().remove_listener(hide_sidebar_keybind_handle);
 
     chatview->unmount(engine);
     content->unmount(engine);
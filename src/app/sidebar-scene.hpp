@@ -4,6 +4,7 @@
 #include "conn.hpp"
 #include "dao/chat.hpp"
 #include "eng/engine.hpp"
+#include "eng/layer-scene.hpp"
 #include "eng/scene.hpp"
 #include "fmt/color.h"
 #include "key.hpp"
@@ -33,13 +34,16 @@ public:
      * database.
      */
     SidebarScene(std::shared_ptr<eng::Scene> c, shared_ptr<AppState> s)
-        : content{c}, chatview{std::make_unique<ChatViewScene>(s)}, state{s} {}
+        : content{c}, chatview{eng::LayerScene::make(ChatViewScene::make(s))},
+          state{s} {}
 
     void update(eng::Engine &engine) override;
 
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
     void mount(eng::Engine &engine) override;
 
     void unmount(eng::Engine &engine) override;
@@ -51,12 +55,21 @@ public:
 
 private:
     std::shared_ptr<eng::Scene> content;
-    std::unique_ptr<ChatViewScene> chatview;
+    /**
+     * The list of chats only changes with the state, so it is cached.
+     */
+    std::shared_ptr<eng::LayerScene> chatview;
 
-    eng::Engine::EventBus::Handle hide_sidebar_keybind_handle;
+    eng::KeyMap::Handle hide_sidebar_keybind_handle;
 
     shared_ptr<AppState> state;
 
     bool show_sidebar{true};
+
+    /**
+     * The rectangle and visibility of the sidebar on the last `damage()`.
+     */
+    term::Rect damaged_area;
+    bool damaged_show_sidebar{};
 };
 } // namespace uppr::app
@@ -6,11 +6,14 @@
 #include "dao/message.hpp"
 #include "dao/user.hpp"
 #include "message.hpp"
+#include "metrics.hpp"
 #include "models/address.hpp"
 #include "models/chat.hpp"
 #include "models/user.hpp"
+#include "reactor.hpp"
 #include "result.hpp"
 #include "safe-queue.hpp"
+#include "trace.hpp"
 #include "udpmsg.hpp"
 #include <algorithm>
 #include <eventpp/eventqueue.h>
@@ -22,6 +25,8 @@
 #include <optional>
 #include <sockpp/udp_socket.h>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -48,6 +53,7 @@ public:
             selected_chat = 0;
         else
             selected_chat = (selected_chat + 1) % chats.size();
+        touch();
 
         // Needs to update this every time we change the selected chat
         fetch_users_of_chat();
@@ -67,6 +73,7 @@ public:
         if (chats.size() == 0) return -1;
 
         if (--selected_chat < 0) selected_chat = chats.size() - 1;
+        touch();
 
         // Needs to update this every time we change the selected chat
         fetch_users_of_chat();
@@ -80,6 +87,7 @@ public:
      */
     void deselect_chat() {
         selected_chat = -1;
+        touch();
 
         // Needs to update this every time we change the selected chat
         fetch_users_of_chat();
@@ -128,7 +136,10 @@ public:
     /**
      * Update the list of chats with new values from the database
      */
-    void fetch_chats() { chats = chat_dao.all(); }
+    void fetch_chats() {
+        chats = chat_dao.all();
+        touch();
+    }
 
     /**
      * Get all users.
@@ -158,7 +169,10 @@ public:
     /**
      * Update the list of users with new values from the database
      */
-    void fetch_users() { users = user_dao.all(); }
+    void fetch_users() {
+        users = user_dao.all();
+        touch();
+    }
 
     /**
      * Update the list of users of current chat.
@@ -169,6 +183,8 @@ public:
             members_of_chat = get_users_of_chat(*sel);
         else
             members_of_chat.clear();
+
+        touch();
     }
 
     /**
@@ -245,6 +261,9 @@ public:
 
     /**
      * Push a string message (sent from the current chat).
+     *
+     * Each line is sent as its own message, and lines too big for a single
+     * datagram are split into several.
      */
     void push_message(string_view message) {
         if (!has_chat_selected()) {
@@ -252,26 +271,39 @@ public:
             return;
         }
 
-        models::MessageModel model{
-            .id = -1,
-            .content = std::string{message},
-            .sent = false,
-            .received = false,
-            .error = "",
-            .in_chat = get_selected_chatmodel()->id,
-            .sent_by = -1, // this should be filled in on receiving, so we set
-                           // it to nothing here (this way we signal that -1
-                           // means "sent by us")
-        };
+        // The latency of sending is counted from here
+        const auto pushed = std::chrono::steady_clock::now();
 
-        models::UdpMessage msg{
-            .content = model.content,
+        // Everything but the content is the same for every part
+        models::UdpMessage empty{
+            .content = "",
             .sent_by = name,
             .sent_from = get_selected_chatmodel()->name,
         };
 
-        const auto id = message_dao.insert(model);
-        send_message(id, msg);
+        // Longer contents take 2 more bytes to say their size
+        const auto max_content =
+            models::UdpMessage::max_wire_size - msgpack::pack(empty).size() - 2;
+
+        while (!message.empty()) {
+            auto line = message.substr(0, message.find_first_of("\r\n"));
+            message.remove_prefix(std::min(line.size() + 1, message.size()));
+
+            while (!line.empty()) {
+                // Dont split a character in half
+                auto n = std::min(line.size(), max_content);
+                while (n > 0 && n < line.size() &&
+                       (static_cast<uchar>(line[n]) & 0xC0) == 0x80)
+                    n--;
+
+                // No character starts in there (it is not really text), so
+                // split it anyway
+                if (n == 0) n = std::min(line.size(), max_content);
+
+                push_single_message(line.substr(0, n), pushed);
+                line.remove_prefix(n);
+            }
+        }
     }
 
     void recv_message(const models::UdpMessage &msg) {
@@ -308,12 +340,22 @@ public:
 
     auto &get_outbound_message_list() { return outbound_messages; }
 
+    /**
+     * Set what is woken up when an outbound message is done sending, so that
+     * its result is picked up right away.
+     */
+    void set_waker(os::Waker w) { waker = std::move(w); }
+
     void set_message_with_error(int msg_id, const std::string &error) {
         message_dao.update_with_error(msg_id, error);
+        end_send(msg_id, false);
+        touch();
     }
 
     void set_message_with_sent(int msg_id) {
         message_dao.update_with_sent(msg_id, true);
+        end_send(msg_id, true);
+        touch();
     }
 
     std::vector<models::MessageModel> get_messages_of_current_chat() {
@@ -327,8 +369,50 @@ public:
 
     int get_port() const { return port; }
 
+    /**
+     * A counter that changes every time that something in the state (or in
+     * the database through it) changes. Scenes can compare it with the value
+     * from when they last drew to know if they need to draw again.
+     */
+    u64 get_generation() const noexcept { return generation; }
+
 private:
-    void send_message(int local_id, models::UdpMessage msg) {
+    /**
+     * Mark that something changed.
+     */
+    void touch() { generation++; }
+
+    /**
+     * Push a message that fits in a single datagram.
+     */
+    void push_single_message(string_view message,
+                             std::chrono::steady_clock::time_point pushed) {
+        models::MessageModel model{
+            .id = -1,
+            .content = std::string{message},
+            .sent = false,
+            .received = false,
+            .error = "",
+            .in_chat = get_selected_chatmodel()->id,
+            .sent_by = -1, // this should be filled in on receiving, so we set
+                           // it to nothing here (this way we signal that -1
+                           // means "sent by us")
+        };
+
+        models::UdpMessage msg{
+            .content = model.content,
+            .sent_by = name,
+            .sent_from = get_selected_chatmodel()->name,
+        };
+
+        const auto id = message_dao.insert(model);
+        touch();
+
+        send_message(id, msg, pushed);
+    }
+
+    void send_message(int local_id, models::UdpMessage msg,
+                      std::chrono::steady_clock::time_point pushed) {
         std::list<std::future<std::pair<int, std::string>>> results;
 
         for (const auto &member : members_of_chat) {
@@ -340,31 +424,59 @@ private:
             LOG_F(5, "sending msg '{}' to {}:{}", msg.content, addr.host,
                   addr.port);
 
-            auto result = std::async(std::launch::async, [=]() mutable {
+            // Not `std::async`, as the waker has to be called after the
+            // result is ready, and there the result is set on return
+            std::promise<std::pair<int, std::string>> result;
+            results.push_back(result.get_future());
+
+            std::thread{[=, waker = waker,
+                         result = std::move(result)]() mutable {
+                trace::set_thread_name("sender");
+                const trace::Span span{"send", "net"};
+
                 const auto payload = msgpack::pack(msg);
+                std::string error;
 
                 try {
                     sockpp::udp_socket sock;
                     const sockpp::inet_address udp_addr{
                         addr.host, static_cast<in_port_t>(addr.port)};
 
+                    const trace::Span send_span{"send_to", "net"};
                     sock.send_to(payload.data(), payload.size(), udp_addr);
+                    metrics::datagrams_sent.add();
                 } catch (const std::exception &e) {
                     LOG_F(ERROR, "error sending message '{}' to {}:{}: {}",
                           msg.content, addr.host, addr.port, e.what());
 
-                    return std::make_pair(local_id, std::string{e.what()});
+                    error = e.what();
                 }
 
-                return std::make_pair(local_id, ""s);
-            });
-
-            results.push_back(std::move(result));
+                result.set_value(std::make_pair(local_id, std::move(error)));
+                waker.wake();
+            }}.detach();
         }
 
+        if (!results.empty()) sends[local_id] = {pushed, results.size()};
         outbound_messages.push_back(std::move(results));
     }
 
+    /**
+     * One of the sends of a message ended, record how long it took if it was
+     * sent.
+     */
+    void end_send(int msg_id, bool sent) {
+        const auto it = sends.find(msg_id);
+        if (it == sends.end()) return;
+
+        auto &[pushed, pending] = it->second;
+        if (sent)
+            metrics::send_latency.record(std::chrono::steady_clock::now() -
+                                         pushed);
+
+        if (--pending == 0) sends.erase(it);
+    }
+
 private:
     /**
      * The index of the currently selected chat. This will be negative if no
@@ -372,6 +484,11 @@ private:
      */
     int selected_chat{-1};
 
+    /**
+     * See `get_generation()`.
+     */
+    u64 generation{};
+
     /**
      * Store all of the chats.
      */
@@ -394,6 +511,19 @@ private:
     std::list<std::list<std::future<std::pair<int, std::string>>>>
         outbound_messages;
 
+    /**
+     * When each outbound message was pushed, and how many of its sends did
+     * not end yet.
+     */
+    std::unordered_map<int,
+                       std::pair<std::chrono::steady_clock::time_point, usize>>
+        sends;
+
+    /**
+     * Woken up when an outbound message is done (see `set_waker()`).
+     */
+    os::Waker waker;
+
     /**
      * Store a reference to the database connection.
      */
@@ -4,30 +4,80 @@
 namespace uppr::app {
 void WriteMsgScene::draw(eng::Engine &engine, term::Transform transform,
                          term::Size size, term::TermScreen &screen) {
-    transform += {1, 0};
-    screen.print(transform, ">");
-    transform += {2, 0};
+    auto canvas = screen.canvas(transform, size);
+    canvas.print(1, 0, ">");
 
-    if (wants_input) {
-        const auto data = screen.inputline(transform, 45);
+    const auto width = static_cast<usize>(std::max<int>(size.getx() - 4, 0));
+    editor.draw(canvas.view({3, 0}, {width, 1}), {}, writing);
+}
 
-        state->push_message(data);
+void WriteMsgScene::damage(term::Rect area, term::TermScreen &screen) {
+    if (editor.get_generation() == damaged_generation &&
+        writing == damaged_writing)
+        return;
 
-        wants_input = false;
-    }
+    screen.damage({area.tl, {area.size.getx(), 1}});
+
+    damaged_generation = editor.get_generation();
+    damaged_writing = writing;
 }
 
 void WriteMsgScene::mount(eng::Engine &engine) {
-    start_writing_keybind_handle =
-        engine.get_eventbus().appendListener('m', [this](char) {
+    // Both are skipped while a modal has the focus
+    start_writing_keybind_handle = engine.get_keymap().add_listener(
+        'm',
+        [this, &engine](char) {
+            if (state->has_chat_selected()) start_writing(engine);
+        },
+        this);
+
+    // Pasting starts writing with the pasted text
+    paste_handle = engine.get_keymap().add_listener(
+        eng::Event::NonChar::paste,
+        [this, &engine](char) {
             if (!state->has_chat_selected()) return;
 
-            wants_input = !wants_input;
-            LOG_F(9, "wants input");
-        });
+            start_writing(engine);
+            editor.insert(engine.get_paste());
+        },
+        this);
 }
 
 void WriteMsgScene::unmount(eng::Engine &engine) {
-    engine.get_eventbus().removeListener('m', start_writing_keybind_handle);
+    if (writing) stop_writing(engine);
+
+    engine.get_keymap().remove_listener(start_writing_keybind_handle);
+    engine.get_keymap().remove_listener(paste_handle);
+}
+
+void WriteMsgScene::start_writing(eng::Engine &engine) {
+    LOG_F(9, "started writing");
+
+    writing = true;
+    engine.grab_input([this, &engine](eng::Event e) { on_key(engine, e); });
+}
+
+void WriteMsgScene::stop_writing(eng::Engine &engine) {
+    LOG_F(9, "stopped writing");
+
+    writing = false;
+    engine.release_input();
+}
+
+void WriteMsgScene::on_key(eng::Engine &engine, eng::Event e) {
+    if (e.nch == eng::Event::NonChar::esc) {
+        // What was written stays there for later
+        stop_writing(engine);
+    } else if (e.nch == eng::Event::NonChar::paste) {
+        editor.insert(engine.get_paste());
+    } else if (e.nch == eng::Event::NonChar::none &&
+               (e.ch == '\r' || e.ch == '\n')) {
+        // Keep writing after sending, for the next message
+        const auto message = editor.submit();
+        if (!message.empty() && state->has_chat_selected())
+            state->push_message(message);
+    } else {
+        editor.handle(e);
+    }
 }
 } // namespace uppr::app
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "engine.hpp"
+#include "line-edit.hpp"
 #include "scene.hpp"
 #include "state.hpp"
 #include <memory>
 namespace uppr::app {
 
+/**
+ * The line where messages are written. Pressing `m` (or pasting) starts
+ * writing, enter sends and ESC stops.
+ *
+ * Writing happens inside of the engine, so messages keep arriving and being
+ * shown while doing it.
+ */
 class WriteMsgScene : public eng::Scene {
 public:
     WriteMsgScene(shared_ptr<AppState> s) : state{s} {}
@@ -15,6 +23,8 @@ public:
     void draw(eng::Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
     void mount(eng::Engine &engine) override;
 
     void unmount(eng::Engine &engine) override;
@@ -23,11 +33,40 @@ public:
         return std::make_shared<WriteMsgScene>(s);
     }
 
+private:
+    /**
+     * Grab the input and send it to the editor.
+     */
+    void start_writing(eng::Engine &engine);
+
+    void stop_writing(eng::Engine &engine);
+
+    /**
+     * Handle a key while writing.
+     */
+    void on_key(eng::Engine &engine, eng::Event e);
+
 private:
     shared_ptr<AppState> state;
 
-    eng::Engine::EventBus::Handle start_writing_keybind_handle;
+    eng::KeyMap::Handle start_writing_keybind_handle;
+
+    eng::KeyMap::Handle paste_handle;
+
+    /**
+     * What is being written. Big enough for the biggest paste.
+     */
+    eng::LineEdit editor{eng::InputParser::max_paste_size};
+
+    /**
+     * If the input is grabbed by the editor.
+     */
+    bool writing{};
 
-    bool wants_input{false};
+    /**
+     * What was drawn when we last said that it changed.
+     */
+    u64 damaged_generation{~0ULL};
+    bool damaged_writing{};
 };
 } // namespace uppr::app
@@ -1,5 +1,7 @@
 #include "db/result.hpp"
 #include "loguru.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
 #include "stmt.hpp"
 
 namespace uppr::db {
@@ -32,7 +34,18 @@ void PreparedStmt::reset_stmt() const {
 }
 
 Result PreparedStmt::step() const {
+    // The first step after preparing or resetting is a new query
+    if (!sqlite3_stmt_busy(stmt)) metrics::db_queries.add();
+
+    const auto start = std::chrono::steady_clock::now();
     Result r = sqlite3_step(stmt);
+    const auto end = std::chrono::steady_clock::now();
+
+    metrics::db_step.record(end - start);
+    if (trace::enabled()) {
+        const auto sql = sqlite3_sql(stmt);
+        trace::record(trace::intern(sql ? sql : "step"), "db", start, end);
+    }
     if (!(r.is_ok() || r.is_done() || r.is_row()))
         throw DatabaseError{"Error running step on statement", r};
 
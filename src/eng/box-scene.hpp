@@ -17,17 +17,34 @@ public:
              std::shared_ptr<Scene> child_scene)
         : opts{box_opts}, child{child_scene}, origin{t}, size{s} {}
 
-    void update(Engine &engine) override { child->update(engine); }
+    void update(Engine &engine) override { child->run_update(engine); }
 
     void draw(Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override {
         transform += origin;
         screen.box(transform, size.getx(), size.gety(), opts);
 
-        child->draw(engine, origin + term::Transform{1, 1}, size - 1, screen);
+        child->run_draw(engine, origin + term::Transform{1, 1}, size - 1,
+                        screen);
     }
 
-    void mount(Engine &engine) override { child->mount(engine); }
+    void damage(term::Rect area, term::TermScreen &screen) override {
+        // The border only changes when it moves
+        if (area != last_area) {
+            screen.damage(
+                {area.tl + origin, area.size + term::Size{1, 1}});
+            last_area = area;
+        }
+
+        const term::Rect inner{origin + term::Transform{1, 1},
+                               area.size - 1};
+        child->damage(inner.intersect(area), screen);
+    }
+
+    void mount(Engine &engine) override {
+        last_area = {};
+        child->mount(engine);
+    }
 
     void unmount(Engine &engine) override { child->unmount(engine); }
 
@@ -44,5 +61,10 @@ private:
     std::shared_ptr<Scene> child;
     term::Transform origin;
     term::Size size;
+
+    /**
+     * Where the border was last damaged.
+     */
+    term::Rect last_area;
 };
 } // namespace uppr::eng
@@ -1,8 +1,12 @@
 #include "engine.hpp"
+#include "alloc.hpp"
 #include "key.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
 #include <bits/chrono.h>
 #include <chrono>
-#include <thread>
+#include <utility>
 
 namespace uppr::eng {
 
@@ -12,24 +16,74 @@ void Engine::run() {
     // First things first, reset the terminal state
     // screen->clear_term();
 
+    // Frames that allocated anything, which should be none once everything
+    // has warmed up
+    usize frames{};
+    usize allocating_frames{};
+    usize max_allocations{};
+
+    // Frames that were too late to be drawn
+    usize skipped_frames{};
+
+    steady_clock::time_point start{};
+    trace::set_thread_name("engine");
+
     while (should_run()) {
+        wait_for_frame(start);
+
         // Record when the frame was started
-        const auto start = steady_clock::now();
+        start = steady_clock::now();
+        const auto allocations_start = alloc::thread_count();
+        profiler.begin_frame();
 
-        poll_events();
+        {
+            const Profiler::Scope scope{profiler, "input"};
+            poll_events();
+        }
 
+        // Resizes are only flagged by the signal handler, do them here where
+        // nothing is using the buffer
+        screen->poll_resize();
         screen->clear();
 
         if (current_scene) {
             // Run updates on the current scene
-            current_scene->update(*this);
+            {
+                const Profiler::Scope scope{profiler, "update"};
+                current_scene->run_update(*this);
+            }
 
             const auto update_end = steady_clock::now();
-            update_time =
-                duration_cast<microseconds>(update_end - start).count();
+            const auto update = duration_cast<microseconds>(update_end - start);
+            update_time = update.count();
+
+            // A frame that is already late may leave drawing to the next one,
+            // which runs right away with whatever else came in meanwhile
+            if (!scheduler.should_draw(update)) {
+                // Nothing is left over from the last frame, as the perf
+                // scene would take it as this one's
+                draw_time = 0;
+                commit_time = 0;
+                frame_time = update_time;
+                frame_allocations = alloc::thread_count() - allocations_start;
+                metrics::frame_time.record(update);
+                skipped_frames++;
 
-            // And then draw
-            current_scene->draw(*this, {}, screen->get_size(), *screen);
+                profiler.end_frame(scheduler.get_budget());
+                continue;
+            }
+
+            // And then draw, saying what changed so that only that is
+            // looked at when committing
+            {
+                const Profiler::Scope scope{profiler, "draw"};
+                current_scene->run_draw(*this, {}, screen->get_size(),
+                                        *screen);
+            }
+            {
+                const Profiler::Scope scope{profiler, "damage"};
+                current_scene->damage({{}, screen->get_size()}, *screen);
+            }
 
             const auto draw_end = steady_clock::now();
             draw_time =
@@ -42,63 +96,165 @@ void Engine::run() {
         const auto end_scene = steady_clock::now();
 
         // Actually commit the screen pixels to the terminal
-        screen->commit();
+        {
+            const Profiler::Scope scope{profiler, "commit"};
+            screen->commit();
+        }
 
         const auto end = steady_clock::now();
         frame_time = duration_cast<microseconds>(end - start).count();
-        commit_time = duration_cast<microseconds>(end - end_scene).count();
+        metrics::frame_time.record(end - start);
+
+        frame_allocations = alloc::thread_count() - allocations_start;
+        frames++;
+        allocating_frames += frame_allocations > 0;
+        max_allocations = std::max(max_allocations, frame_allocations);
+
+        // With a render thread the commit above is just a handoff, so report
+        // how long frames take to actually reach the terminal instead
+        commit_time =
+            screen->has_render_thread()
+                ? screen->get_commit_latency()
+                : duration_cast<microseconds>(end - end_scene).count();
+
+        // Whatever ate the frame is logged if it was too long
+        profiler.end_frame(scheduler.get_budget());
+    }
+
+    LOG_F(INFO, "{} of {} frames allocated, at most {} times",
+          allocating_frames, frames, max_allocations);
+    LOG_F(INFO, "{} frames skipped their draw", skipped_frames);
+    profiler.log_summary();
+}
+
+void Engine::wait_for_frame(std::chrono::steady_clock::time_point last_start) {
+    using namespace std::chrono;
+
+    // A frame that skipped its draw is followed by one right away
+    if (scheduler.is_catching_up()) return;
+
+    // Nothing is blocked on when there is already a reason for a frame (a
+    // resize that came in right before waiting would otherwise be missed, as
+    // the signal would not interrupt anything)
+    auto pending = std::exchange(frame_requested, false);
+    if (screen->resize_pending()) pending = true;
+
+    // Input is read as soon as it arrives, so that keys are handled in order
+    // and without waiting for a frame. Timing out means that a lone `ESC`
+    // waited long enough. Only a part of an escape sequence is not worth a
+    // frame.
+    while (!pending && should_run()) {
+        const auto w = reactor.wait(input_timeout());
+        const auto events = w.input || !w.any() ? poll_events() : 0;
+        note_activity(events, w);
+
+        pending = events > 0 || w.woken || w.timer || w.interrupted;
+    }
+
+    // Dont go faster than the scheduler says. Anything that happens until
+    // then is handled in the same frame, and may make it sooner
+    for (auto now = steady_clock::now();
+         now < last_start + scheduler.get_period(now);
+         now = steady_clock::now()) {
+        const auto next = last_start + scheduler.get_period(now);
+
+        auto timeout = ceil<milliseconds>(next - now);
+        if (input.waiting()) timeout = std::min(timeout, input_timeout());
 
-        // Dont go too fast
-        if (frame_time < period_millis)
-            std::this_thread::sleep_for(
-                microseconds{period_millis - frame_time});
+        const auto w = reactor.wait(timeout);
+        const auto events = w.input || !w.any() ? poll_events() : 0;
+        note_activity(events, w);
     }
 }
 
+void Engine::note_activity(usize events, const os::Reactor::Wakeup &w) {
+    const auto now = std::chrono::steady_clock::now();
+
+    if (events > 0) scheduler.note(FrameScheduler::Activity::input, now);
+    if (w.woken) scheduler.note(FrameScheduler::Activity::wake, now);
+}
+
 void Engine::switch_scene(std::shared_ptr<Scene> s) {
     // Call unmount hook before removing
     if (current_scene) current_scene->unmount(*this);
 
     current_scene = s;
 
+    // Nothing of what is on screen belongs to the new scene
+    screen->damage_all();
+
     // Call mount hook after adding
     if (current_scene) current_scene->mount(*this);
 }
 
-void Engine::poll_events() {
+usize Engine::poll_events() {
+    using namespace std::chrono;
+
+    usize count{};
+
+    // All of it in as few reads as possible, a paste can be big
+    std::array<char, 4096> buf;
     while (true) {
-        const auto c = screen->readc();
-        if (c == 0) break;
+        const auto bytes = screen->read(buf);
+        if (bytes.empty()) break;
+
+        const auto was_pending = input.pending();
+        const auto events = input.feed(bytes);
+        dispatch_events(events);
+        count += events.size();
+
+        // The rest of a sequence has a little while to arrive, from when it
+        // started. A paste has a while from its last byte, as its end may
+        // never come (and everything typed would be taken as pasted)
+        if (input.pasting())
+            input_deadline = steady_clock::now() + 500ms;
+        else if (input.pending() && (!was_pending || !events.empty()))
+            input_deadline = steady_clock::now() + 25ms;
+
+        if (bytes.size() < buf.size()) break;
+    }
+
+    if (input.waiting() && steady_clock::now() >= input_deadline) {
+        const auto events = input.flush();
+        dispatch_events(events);
+        count += events.size();
+    }
+
+    return count;
+}
+
+void Engine::dispatch_events(span<const Event> events) {
+    usize pastes{};
+
+    for (const auto e : events) {
+        if (e.nch == Event::NonChar::paste) paste = input.get_paste(pastes++);
 
         // Ctrl+Q is quit, always
-        if (term::is_ctrl(c, 'q')) finalize();
-        if (term::is_escseq(c)) {
-            LOG_F(9, "received escape seq");
-
-            screen->set_termios_control(1, 0);
-            screen->commit_termios(false);
-
-            std::array<char, 8> buf;
-            const auto sequence = screen->read(buf);
-            screen->set_termios_control(0, 0);
-            screen->commit_termios(false);
-
-            // The ESC key
-            if (term::is_esc(sequence)) {
-                LOG_F(9, "received key: 'ESC'");
-                eventbus.dispatch(Event::NonChar::esc, Event::NonChar::esc);
-            } else if (term::is_shif_tab(sequence)) {
-                LOG_F(9, "received key: 'shift+tab'");
-                eventbus.dispatch(Event::NonChar::shift_tab,
-                                  Event::NonChar::shift_tab);
-            } else {
-                LOG_F(8, "received unknown escape sequence: '{}'", sequence);
-            }
-        }
+        if (e.nch == Event::NonChar::none && term::is_ctrl(e.ch, 'q'))
+            finalize();
+
+        // And F12 writes the trace so far, if there is one
+        if (e.nch == Event::NonChar::f12) trace::flush();
 
-        LOG_F(9, "received key: '{}' ({:d}, {:d})", c, c, term::ctrl(c));
+        if (grab) {
+            // The grab may release itself, so dont call it in place
+            const auto g = grab;
+            g(e);
+            continue;
+        }
 
-        eventbus.dispatch(c, c);
+        keymap.dispatch(e);
     }
+
+    paste = {};
+}
+
+std::chrono::milliseconds Engine::input_timeout() const {
+    using namespace std::chrono;
+
+    if (!input.waiting()) return milliseconds{-1};
+
+    const auto left = ceil<milliseconds>(input_deadline - steady_clock::now());
+    return std::max(left, milliseconds{0});
 }
 } // namespace uppr::eng
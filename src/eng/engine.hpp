@@ -1,11 +1,17 @@
 #pragma once
 
 #include "event.hpp"
-#include "eventpp/eventdispatcher.h"
+#include "frame-scheduler.hpp"
+#include "input-parser.hpp"
+#include "key-map.hpp"
+#include "profiler.hpp"
+#include "reactor.hpp"
 #include "scene.hpp"
 #include "screen.hpp"
 #include "vector2.hpp"
 
+#include <functional>
+
 namespace uppr::eng {
 
 /**
@@ -34,16 +40,35 @@ namespace uppr::eng {
  *
  *
  * ```
+ *
+ * Frames are only run when something happens: a key is pressed, the terminal
+ * is resized, another thread calls `Waker::wake()` (see `get_waker()`), the
+ * animation timer fires (see `set_animation_period()`) or a scene asks for one
+ * with `request_frame()`. Otherwise the engine blocks in its `os::Reactor`
+ * without using any CPU. Everything that happens while waiting out the excess
+ * time of a frame is handled together in the next one. How long that is comes
+ * from the `FrameScheduler`, which goes faster while there is input or
+ * traffic and slows down when there is not (see `get_scheduler()`).
+ *
+ * When the screen has a render thread, the commit is only a handoff and the
+ * commit time is the latency until the frame actually reaches the terminal.
  */
 class Engine {
 public:
-    using EventBus = eventpp::EventDispatcher<Event, void(Event)>;
+    /**
+     * Takes every event while it is set, instead of the key map (see
+     * `grab_input()`).
+     */
+    using InputGrab = std::function<void(Event)>;
 
     Engine(int fps_, std::shared_ptr<term::TermScreen> t)
-        : screen{t}, fps{fps_}, period_millis{max_frame_time()} {}
+        : screen{t}, scheduler{fps_} {
+        reactor.watch_input(screen->get_input_fd());
+    }
     Engine(int fps_, std::shared_ptr<term::TermScreen> t,
            std::shared_ptr<Scene> s)
-        : screen{t}, fps{fps_}, period_millis{max_frame_time()} {
+        : screen{t}, scheduler{fps_} {
+        reactor.watch_input(screen->get_input_fd());
         switch_scene(s);
     }
 
@@ -69,6 +94,25 @@ public:
      */
     constexpr void finalize() { running = false; }
 
+    /**
+     * Run another frame after this one, even if nothing else happens.
+     */
+    constexpr void request_frame() { frame_requested = true; }
+
+    /**
+     * Get something that other threads can use to make the engine run a frame
+     * (like when a message arrives from the network).
+     */
+    os::Waker get_waker() const { return reactor.get_waker(); }
+
+    /**
+     * Run a frame every `period` for animations, or stop if it is zero. Frames
+     * still never go faster than the scheduler allows.
+     */
+    void set_animation_period(std::chrono::microseconds period) {
+        reactor.set_timer(period);
+    }
+
     /**
      * Get the size of the screen.
      */
@@ -90,14 +134,39 @@ public:
     constexpr int get_draw_time() const { return draw_time; }
 
     /**
-     * get the time taken to commit the pixel buffer to the terminal
+     * get the time taken to commit the pixel buffer to the terminal (or the
+     * latency of the render thread, if there is one)
      */
     constexpr int get_commit_time() const { return commit_time; }
 
+    /**
+     * Get the number of heap allocations done by the engine thread during the
+     * last frame (see `alloc::thread_count()`).
+     */
+    constexpr usize get_frame_allocations() const { return frame_allocations; }
+
+    /**
+     * Get the counters of what was written to the terminal.
+     */
+    term::OutputStats get_output_stats() const {
+        return screen->get_output_stats();
+    }
+
+    /**
+     * Get what the time of the frames is spent on, by each part of the frame
+     * and each scene.
+     */
+    Profiler &get_profiler() { return profiler; }
+
     /**
      * Get the maximum time budget of a frame.
      */
-    constexpr int get_max_frame_time() const { return period_millis; }
+    int get_max_frame_time() const { return scheduler.get_budget().count(); }
+
+    /**
+     * Get what paces the frames, to change the FPS or see the current rate.
+     */
+    FrameScheduler &get_scheduler() { return scheduler; }
 
     /**
      * Read a single character from the screen.
@@ -105,20 +174,71 @@ public:
     char readc() const { return screen->readc(); }
 
     /**
-     * Get the event bus in order to add and remove listeners.
+     * Get the last mouse report, for `Event::NonChar::mouse`.
+     */
+    constexpr const InputParser::Mouse &get_mouse() const {
+        return input.get_mouse();
+    }
+
+    /**
+     * Get the text that was pasted, for `Event::NonChar::paste`. Only valid
+     * while the event is being dispatched.
+     */
+    constexpr string_view get_paste() const { return paste; }
+
+    /**
+     * Send every event to `g` instead of the key map, until
+     * `release_input()`. This is for text input, where every key is text and
+     * not a key binding (except for ctrl+q, which always quits, and F12,
+     * which always writes the trace).
+     */
+    void grab_input(InputGrab g) { grab = std::move(g); }
+
+    /**
+     * Go back to sending events to the key map.
+     */
+    void release_input() { grab = nullptr; }
+
+    /**
+     * If something grabbed the input.
+     */
+    bool has_input_grab() const { return static_cast<bool>(grab); }
+
+    /**
+     * Get the key map in order to add and remove listeners.
      */
-    EventBus &get_eventbus() { return eventbus; }
+    KeyMap &get_keymap() { return keymap; }
 
 private:
     /**
-     * Get the maximum frame time in microseconds.
+     * Read everything that is available from the stdin and dispatch the
+     * events in it.
+     *
+     * @return How many events were dispatched.
      */
-    constexpr int max_frame_time() const { return 1000000 / fps; }
+    usize poll_events();
 
     /**
-     * Poll the stdin for keys pressed and transform it to events.
+     * Dispatch a batch of events from the input parser.
      */
-    void poll_events();
+    void dispatch_events(span<const Event> events);
+
+    /**
+     * How long to wait for more input before a lone `ESC` is taken as the
+     * key, or forever if there is nothing to wait for.
+     */
+    std::chrono::milliseconds input_timeout() const;
+
+    /**
+     * Block until there is a reason to run a frame, and then until the
+     * previous one has had all of its time.
+     */
+    void wait_for_frame(std::chrono::steady_clock::time_point last_start);
+
+    /**
+     * Tell the scheduler about what happened while waiting.
+     */
+    void note_activity(usize events, const os::Reactor::Wakeup &w);
 
 private:
     /**
@@ -132,19 +252,45 @@ private:
     std::shared_ptr<term::TermScreen> screen;
 
     /**
-     * Event queue for events (duh)
+     * Who gets each key.
+     */
+    KeyMap keymap;
+
+    /**
+     * See `get_profiler()`.
+     */
+    Profiler profiler;
+
+    /**
+     * What the engine blocks on between frames.
+     */
+    os::Reactor reactor;
+
+    /**
+     * Decodes what is read from the stdin.
+     */
+    InputParser input;
+
+    /**
+     * When the sequence or paste that the input parser is in the middle of is
+     * given up on.
      */
-    EventBus eventbus;
+    std::chrono::steady_clock::time_point input_deadline;
 
     /**
-     * What FPS to run the engine at (or at least try to).
+     * See `get_paste()`.
      */
-    int fps;
+    string_view paste;
 
     /**
-     * The period of a frame, in microseconds.
+     * See `grab_input()`.
      */
-    int period_millis;
+    InputGrab grab;
+
+    /**
+     * See `get_scheduler()`.
+     */
+    FrameScheduler scheduler;
 
     /**
      * The last frame time.
@@ -166,10 +312,21 @@ private:
      */
     int commit_time{};
 
+    /**
+     * Heap allocations during the last frame.
+     */
+    usize frame_allocations{};
+
     /**
      * If the engine is currently running. If this goes false, then the mainloop
      * exits.
      */
     bool running{true};
+
+    /**
+     * If another frame should be run without waiting for anything. The first
+     * frame always runs.
+     */
+    bool frame_requested{true};
 };
 } // namespace uppr::eng
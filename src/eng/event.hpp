@@ -8,6 +8,45 @@ struct Event {
         none = 0,
         esc,
         shift_tab,
+
+        up,
+        down,
+        right,
+        left,
+        home,
+        end,
+        insert,
+        del,
+        page_up,
+        page_down,
+
+        f1,
+        f2,
+        f3,
+        f4,
+        f5,
+        f6,
+        f7,
+        f8,
+        f9,
+        f10,
+        f11,
+        f12,
+
+        /**
+         * A mouse button was pressed or released (see `Engine::get_mouse()`).
+         */
+        mouse,
+
+        /**
+         * Text was pasted (see `Engine::get_paste()`).
+         */
+        paste,
+
+        /**
+         * How many there are, not a key.
+         */
+        count,
     };
 
     char ch{};
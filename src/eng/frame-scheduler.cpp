@@ -0,0 +1,66 @@
+#include "frame-scheduler.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace uppr::eng {
+
+FrameScheduler::FrameScheduler(int max_fps_, int idle_fps_)
+    : max_fps{std::max(max_fps_, 1)},
+      idle_fps{std::clamp(idle_fps_, 1, max_fps)}, peak_fps{double(idle_fps)} {
+}
+
+void FrameScheduler::set_max_fps(int fps) {
+    max_fps = std::max(fps, 1);
+    idle_fps = std::min(idle_fps, max_fps);
+    peak_fps = std::min(peak_fps, double(max_fps));
+
+    LOG_F(INFO, "Running at most at {} FPS, idle at {}", max_fps, idle_fps);
+}
+
+void FrameScheduler::set_idle_fps(int fps) {
+    idle_fps = std::clamp(fps, 1, max_fps);
+
+    LOG_F(INFO, "Running at most at {} FPS, idle at {}", max_fps, idle_fps);
+}
+
+void FrameScheduler::note(Activity a, Clock::time_point now) {
+    switch (a) {
+    case Activity::input: peak_fps = max_fps; break;
+    case Activity::wake:
+        peak_fps = std::min(get_fps(now) * 2, double(max_fps));
+        break;
+    }
+
+    peak_time = now;
+}
+
+double FrameScheduler::get_fps(Clock::time_point now) const {
+    using namespace std::chrono;
+
+    const auto halves = duration<double>(now - peak_time) / half_life;
+    return idle_fps + (peak_fps - idle_fps) * std::exp2(-halves);
+}
+
+FrameScheduler::Clock::duration
+FrameScheduler::get_period(Clock::time_point now) const {
+    using namespace std::chrono;
+
+    return duration_cast<Clock::duration>(duration<double>{1 / get_fps(now)});
+}
+
+bool FrameScheduler::should_draw(std::chrono::microseconds update_time) {
+    const auto late = skip_policy == SkipPolicy::late_draws &&
+                      update_time > get_budget() && skips_in_a_row < max_skips;
+
+    if (!late) {
+        skips_in_a_row = 0;
+        return true;
+    }
+
+    skips_in_a_row++;
+    metrics::frames_skipped.add();
+    return false;
+}
+} // namespace uppr::eng
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "commom.hpp"
+
+#include <chrono>
+
+namespace uppr::eng {
+
+/**
+ * Decides how far apart the frames of the engine have to be.
+ *
+ * Frames only run when something happens (see `Engine`), so this is about
+ * how they are paced while things keep happening. Input means that someone
+ * is looking at the screen, so it takes the rate right up to the most FPS.
+ * Other wakeups (like messages from the network) double it on each one, up
+ * to the most. When nothing happens the rate decays back to the idle FPS,
+ * halving the distance every `half_life`, so that a trickle of background
+ * traffic after a while without input is batched into few frames. When
+ * nothing happens at all, no frames run whatever the rate.
+ *
+ * It also decides if a frame whose update went over the budget should skip
+ * its draw to catch up (see `should_draw()`).
+ */
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * What caused a frame.
+     */
+    enum class Activity {
+        input,
+        wake,
+    };
+
+    /**
+     * What to do with frames that are late.
+     */
+    enum class SkipPolicy {
+        /**
+         * Always draw.
+         */
+        never,
+
+        /**
+         * Skip the draw of frames whose update took longer than the budget,
+         * and run the next one right away, at most `max_skips` in a row.
+         */
+        late_draws,
+    };
+
+    /**
+     * How long it takes for the rate to get halfway back to idle.
+     */
+    static constexpr std::chrono::milliseconds half_life{250};
+
+    /**
+     * How many draws can be skipped in a row, so that the screen still
+     * changes when every update is slow.
+     */
+    static constexpr usize max_skips = 2;
+
+    static constexpr int default_idle_fps = 10;
+
+    FrameScheduler(int max_fps, int idle_fps = default_idle_fps);
+
+    /**
+     * Set the most FPS, which is also what the budget of a frame comes from.
+     * The idle FPS is lowered if it was above it.
+     */
+    void set_max_fps(int fps);
+
+    /**
+     * Set the FPS that the rate decays to, up to the most FPS.
+     */
+    void set_idle_fps(int fps);
+
+    int get_max_fps() const noexcept { return max_fps; }
+
+    int get_idle_fps() const noexcept { return idle_fps; }
+
+    void set_skip_policy(SkipPolicy p) noexcept { skip_policy = p; }
+
+    SkipPolicy get_skip_policy() const noexcept { return skip_policy; }
+
+    /**
+     * Say that something happened that needs a frame.
+     */
+    void note(Activity a, Clock::time_point now);
+
+    /**
+     * Get the rate at `now`.
+     */
+    double get_fps(Clock::time_point now) const;
+
+    /**
+     * Get how long after the start of the last frame the next one can start.
+     */
+    Clock::duration get_period(Clock::time_point now) const;
+
+    /**
+     * Get how long a frame can take, the period at the most FPS.
+     */
+    std::chrono::microseconds get_budget() const {
+        return std::chrono::microseconds{1000000 / max_fps};
+    }
+
+    /**
+     * After the update of a frame, decide if it is drawn. Skipped frames are
+     * counted in `metrics::frames_skipped`.
+     */
+    bool should_draw(std::chrono::microseconds update_time);
+
+    /**
+     * If the last frame skipped its draw, so the next one should not wait.
+     */
+    bool is_catching_up() const noexcept { return skips_in_a_row > 0; }
+
+private:
+    int max_fps;
+    int idle_fps;
+
+    /**
+     * The rate at `peak_time`, which decays from there.
+     */
+    double peak_fps;
+    Clock::time_point peak_time{};
+
+    SkipPolicy skip_policy{SkipPolicy::late_draws};
+    usize skips_in_a_row{};
+};
+} // namespace uppr::eng
@@ -0,0 +1,334 @@
+#include "input-parser.hpp"
+#include "loguru.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+
+namespace uppr::eng {
+
+namespace {
+
+using Action = InputParser::Action;
+using State = InputParser::State;
+using Key = Event::NonChar;
+
+using Row = array<Action, 256>;
+using Table = array<Row, static_cast<usize>(State::count)>;
+
+constexpr void set_range(Row &row, u8 from, u8 to, Action a) {
+    for (auto c = from; c <= to; c++) row[c] = a;
+}
+
+/**
+ * What to do with each byte in each state.
+ */
+constexpr Table make_table() {
+    Table t{};
+    auto &ground = t[static_cast<usize>(State::ground)];
+    auto &escape = t[static_cast<usize>(State::escape)];
+    auto &csi = t[static_cast<usize>(State::csi)];
+    auto &ss3 = t[static_cast<usize>(State::ss3)];
+    auto &x10_mouse = t[static_cast<usize>(State::x10_mouse)];
+    auto &paste = t[static_cast<usize>(State::paste)];
+
+    // Everything is a character, even the bytes of UTF-8 sequences, the
+    // listeners get them one at a time like before
+    ground.fill(Action::print);
+    ground[0x1B] = Action::escape;
+
+    escape.fill(Action::alt);
+    escape['['] = Action::csi;
+    escape['O'] = Action::ss3;
+    escape[0x1B] = Action::escape;
+
+    // An `ESC` in the middle of a sequence starts a new one, and control
+    // characters cant be in one
+    csi.fill(Action::abort);
+    set_range(csi, 0x20, 0x3F, Action::param);
+    set_range(csi, 0x40, 0x7E, Action::csi_end);
+    csi[0x1B] = Action::escape;
+
+    ss3.fill(Action::abort);
+    set_range(ss3, 0x40, 0x7E, Action::ss3_end);
+    ss3[0x1B] = Action::escape;
+
+    // These are raw bytes, anything goes
+    x10_mouse.fill(Action::mouse);
+    paste.fill(Action::paste);
+
+    return t;
+}
+
+constexpr auto table = make_table();
+
+/**
+ * Keys for the final bytes of `CSI` and `SS3` sequences without the `~`, from
+ * `@` up to `~`.
+ */
+constexpr array<Key, 0x3F> make_final_keys() {
+    array<Key, 0x3F> k{};
+    k['A' - 0x40] = Key::up;
+    k['B' - 0x40] = Key::down;
+    k['C' - 0x40] = Key::right;
+    k['D' - 0x40] = Key::left;
+    k['H' - 0x40] = Key::home;
+    k['F' - 0x40] = Key::end;
+    k['Z' - 0x40] = Key::shift_tab;
+    k['P' - 0x40] = Key::f1;
+    k['Q' - 0x40] = Key::f2;
+    k['R' - 0x40] = Key::f3;
+    k['S' - 0x40] = Key::f4;
+
+    return k;
+}
+
+constexpr auto final_keys = make_final_keys();
+
+/**
+ * Keys for `CSI <n> ~` sequences, by `n`.
+ */
+constexpr array<Key, 25> tilde_keys{
+    Key::none,   Key::home,    Key::insert,    Key::del,  Key::end,
+    Key::page_up, Key::page_down, Key::home,   Key::end,  Key::none,
+    Key::none,   Key::f1,      Key::f2,        Key::f3,   Key::f4,
+    Key::f5,     Key::none,    Key::f6,        Key::f7,   Key::f8,
+    Key::f9,     Key::f10,     Key::none,      Key::f11,  Key::f12,
+};
+
+constexpr auto paste_begin = 200;
+constexpr auto paste_end = 201;
+
+/**
+ * How the end of a bracketed paste looks like.
+ */
+constexpr auto paste_end_marker = "\x1B[201~"sv;
+} // namespace
+
+span<const Event> InputParser::feed(string_view bytes) {
+    events.clear();
+    drop_finished_pastes();
+    for (const auto c : bytes) step(c);
+
+    return events;
+}
+
+span<const Event> InputParser::flush() {
+    events.clear();
+    drop_finished_pastes();
+
+    if (state == State::escape) {
+        emit(Key::esc);
+    } else if (state == State::paste) {
+        // What looked like the start of the end marker is dropped, as it
+        // most likely was a cut off one
+        LOG_F(WARNING, "Paste did not end, taking the {} bytes that arrived",
+              paste_text.size() - paste_start);
+        end_paste();
+    } else if (pending()) {
+        LOG_F(8, "dropped an unfinished escape sequence");
+    }
+
+    if (pending()) state = State::ground;
+
+    return events;
+}
+
+void InputParser::step(char c) {
+    const auto byte = static_cast<u8>(c);
+
+    switch (table[static_cast<usize>(state)][byte]) {
+    case Action::ignore:
+        break;
+
+    case Action::print:
+        emit(c);
+        break;
+
+    case Action::escape:
+        // Two in a row means that the first was the key
+        if (state == State::escape) emit(Key::esc);
+        state = State::escape;
+        break;
+
+    case Action::csi:
+        begin_sequence(State::csi);
+        break;
+
+    case Action::ss3:
+        begin_sequence(State::ss3);
+        break;
+
+    case Action::alt:
+        // There is nothing for modifiers in events, so alt+key is the same as
+        // pressing both quickly
+        emit(Key::esc);
+        emit(c);
+        state = State::ground;
+        break;
+
+    case Action::param:
+        collect(c);
+        break;
+
+    case Action::csi_end:
+        state = State::ground;
+        dispatch_csi(c);
+        break;
+
+    case Action::ss3_end:
+        state = State::ground;
+        if (const auto key = final_keys[byte - 0x40]; key != Key::none)
+            emit(key);
+        break;
+
+    case Action::mouse:
+        x10[x10_count++] = byte;
+        if (x10_count == x10.size()) {
+            // Everything is offset by 32 to be printable, and positions
+            // start at 1
+            const u32 b = x10[0] - 32;
+            mouse = {.x = x10[1] - 33,
+                     .y = x10[2] - 33,
+                     .button = b,
+                     .pressed = (b & 3) != 3};
+            emit(Key::mouse);
+            state = State::ground;
+        }
+        break;
+
+    case Action::paste:
+        paste_byte(c);
+        break;
+
+    case Action::abort:
+        LOG_F(8, "dropped an invalid escape sequence at {:d}", byte);
+        state = State::ground;
+        break;
+    }
+}
+
+void InputParser::begin_sequence(State s) {
+    state = s;
+    params.fill(0);
+    param_count = 0;
+    marker = 0;
+}
+
+void InputParser::collect(char c) {
+    if (c >= '0' && c <= '9') {
+        if (param_count == 0) param_count = 1;
+        if (param_count <= params.size()) {
+            auto &p = params[param_count - 1];
+            p = p * 10 + (c - '0');
+        }
+    } else if (c == ';') {
+        param_count = std::max<usize>(param_count, 1) + 1;
+    } else if (c >= '<' && c <= '?') {
+        if (!marker) marker = c;
+    }
+    // Intermediate bytes do not matter for any key
+}
+
+void InputParser::dispatch_csi(char final) {
+    // SGR mouse reports are `CSI < b ; x ; y M` (or `m` for released)
+    if (marker == '<' && (final == 'M' || final == 'm')) {
+        mouse = {.x = static_cast<int>(params[1]) - 1,
+                 .y = static_cast<int>(params[2]) - 1,
+                 .button = params[0],
+                 .pressed = final == 'M'};
+        emit(Key::mouse);
+        return;
+    }
+
+    // Only the plain `CSI M` is followed by 3 raw bytes of a X10 report
+    if (marker) return;
+    if (final == 'M' && param_count == 0) {
+        state = State::x10_mouse;
+        x10_count = 0;
+        return;
+    }
+
+    if (final == '~') {
+        if (params[0] == paste_begin) {
+            state = State::paste;
+            paste_matched = 0;
+            paste_start = paste_text.size();
+            paste_dropped = 0;
+        } else if (params[0] < tilde_keys.size() &&
+                   tilde_keys[params[0]] != Key::none) {
+            emit(tilde_keys[params[0]]);
+        } else if (params[0] != paste_end) {
+            LOG_F(8, "received unknown key: CSI {} ~", params[0]);
+        }
+
+        return;
+    }
+
+    // Any modifiers (the second parameter) are ignored
+    const auto key = final_keys[static_cast<u8>(final) - 0x40];
+    if (key != Key::none)
+        emit(key);
+    else
+        LOG_F(8, "received unknown escape sequence ending in '{}'", final);
+}
+
+void InputParser::paste_byte(char c) {
+    if (c == paste_end_marker[paste_matched]) {
+        if (++paste_matched == paste_end_marker.size()) end_paste();
+        return;
+    }
+
+    // That was not the end marker after all, so the part that looked like it
+    // was pasted too
+    for (const auto m : paste_end_marker.substr(0, paste_matched))
+        append_paste(m);
+    paste_matched = 0;
+
+    if (c == paste_end_marker[0])
+        paste_matched = 1;
+    else
+        append_paste(c);
+}
+
+void InputParser::append_paste(char c) {
+    if (paste_text.size() - paste_start < max_paste_size)
+        paste_text.push_back(c);
+    else
+        paste_dropped++;
+}
+
+void InputParser::end_paste() {
+    state = State::ground;
+
+    if (paste_dropped) {
+        // Dont leave half of a character at the end
+        auto lead = paste_text.size();
+        while (lead > paste_start &&
+               (static_cast<u8>(paste_text[lead - 1]) & 0xC0) == 0x80)
+            lead--;
+
+        if (lead > paste_start) {
+            const auto last = string_view{paste_text}.substr(lead - 1);
+            if (term::decode_utf8(last).second != last.size())
+                paste_text.resize(lead - 1);
+        }
+
+        LOG_F(WARNING, "Pasted text was too big, dropped {} bytes",
+              paste_dropped);
+    }
+
+    pastes.emplace_back(paste_start, paste_text.size());
+    emit(Key::paste);
+}
+
+void InputParser::drop_finished_pastes() {
+    pastes.clear();
+
+    if (state == State::paste) {
+        paste_text.erase(0, paste_start);
+        paste_start = 0;
+    } else {
+        paste_text.clear();
+    }
+}
+} // namespace uppr::eng
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "commom.hpp"
+#include "event.hpp"
+
+#include <vector>
+
+namespace uppr::eng {
+
+/**
+ * Turns the bytes read from the terminal into events.
+ *
+ * This is a state machine driven by a table of what to do with each byte in
+ * each state, in the spirit of the DEC/VT500 parser. It understands plain
+ * characters, `CSI` and `SS3` sequences (arrows, shift-tab, home/end, function
+ * keys and so on), SGR and X10 mouse reports and bracketed paste.
+ *
+ * Bytes can be given in pieces of any size, a sequence that is split between
+ * two reads continues where it stopped. The only ambiguity is a lone `ESC`,
+ * which looks exactly like the start of a sequence: the parser stays
+ * `pending()` and whoever is reading should `flush()` it if nothing else
+ * arrives in a short while.
+ *
+ * Pasted text is collected (up to `max_paste_size` bytes) and becomes a single
+ * `Event::NonChar::paste`, instead of an event for each byte. If the end of a
+ * paste never arrives, every later byte would be pasted text, so the reader
+ * should also `flush()` it if nothing arrives for a while (see `waiting()`).
+ */
+class InputParser {
+public:
+    /**
+     * How many bytes a single paste can have, anything after that is dropped.
+     */
+    static constexpr usize max_paste_size = 64 * 1024;
+
+    /**
+     * The last mouse report.
+     */
+    struct Mouse {
+        /**
+         * Where the mouse is, zero based.
+         */
+        int x{};
+        int y{};
+
+        /**
+         * The button (and modifiers) as the terminal sent them.
+         */
+        u32 button{};
+
+        /**
+         * If it was pressed (or dragged) instead of released.
+         */
+        bool pressed{};
+    };
+
+    /**
+     * What can happen to a byte, given the state that the parser is in.
+     */
+    enum class Action : u8 {
+        /**
+         * Drop it.
+         */
+        ignore,
+
+        /**
+         * It is a character by itself.
+         */
+        print,
+
+        /**
+         * It is an `ESC`, starting a sequence.
+         */
+        escape,
+
+        /**
+         * `[` after an `ESC`, starting a control sequence.
+         */
+        csi,
+
+        /**
+         * `O` after an `ESC`, starting a single shift.
+         */
+        ss3,
+
+        /**
+         * Any other character after an `ESC` (like alt+key).
+         */
+        alt,
+
+        /**
+         * A parameter or intermediate byte of a control sequence.
+         */
+        param,
+
+        /**
+         * The final byte of a control sequence.
+         */
+        csi_end,
+
+        /**
+         * The final byte of a single shift.
+         */
+        ss3_end,
+
+        /**
+         * A byte of a X10 mouse report.
+         */
+        mouse,
+
+        /**
+         * A byte of pasted text.
+         */
+        paste,
+
+        /**
+         * Not valid here, drop the sequence that it is in.
+         */
+        abort,
+    };
+
+    enum class State : u8 {
+        ground,
+        escape,
+        csi,
+        ss3,
+        x10_mouse,
+        paste,
+        count,
+    };
+
+public:
+    /**
+     * Parse `bytes`, returning all events that they completed. The events
+     * are valid until the next call.
+     */
+    span<const Event> feed(string_view bytes);
+
+    /**
+     * Give up on waiting for the rest of a sequence, so that a lone `ESC` is
+     * taken as the key by itself, and a paste that did not end is taken as
+     * what arrived of it. The events are valid until the next call.
+     */
+    span<const Event> flush();
+
+    /**
+     * If there are bytes that started a sequence but did not finish it yet.
+     */
+    constexpr bool pending() const noexcept {
+        return state != State::ground && state != State::paste;
+    }
+
+    /**
+     * If the terminal is in the middle of a bracketed paste.
+     */
+    constexpr bool pasting() const noexcept { return state == State::paste; }
+
+    /**
+     * If something is left unfinished, and should be `flush()`ed if the rest
+     * does not arrive.
+     */
+    constexpr bool waiting() const noexcept { return pending() || pasting(); }
+
+    /**
+     * Get the last mouse report, for `Event::NonChar::mouse`.
+     */
+    constexpr const Mouse &get_mouse() const noexcept { return mouse; }
+
+    /**
+     * Get the text of the `i`th `Event::NonChar::paste` of the last batch of
+     * events.
+     */
+    string_view get_paste(usize i) const {
+        const auto [start, end] = pastes[i];
+        return string_view{paste_text}.substr(start, end - start);
+    }
+
+private:
+    void step(char c);
+
+    /**
+     * Start collecting a new sequence.
+     */
+    void begin_sequence(State s);
+
+    /**
+     * Collect a parameter or intermediate byte.
+     */
+    void collect(char c);
+
+    /**
+     * Handle a complete control sequence that ends in `final`.
+     */
+    void dispatch_csi(char final);
+
+    /**
+     * Handle a byte between the bracketed paste markers.
+     */
+    void paste_byte(char c);
+
+    /**
+     * Collect a byte of pasted text.
+     */
+    void append_paste(char c);
+
+    /**
+     * Finish the paste and say that there is one.
+     */
+    void end_paste();
+
+    /**
+     * Forget the pastes of the last batch, but not the one that is still
+     * being received.
+     */
+    void drop_finished_pastes();
+
+    void emit(Event e) { events.push_back(e); }
+
+private:
+    State state{State::ground};
+
+    /**
+     * The numeric parameters of the current control sequence.
+     */
+    array<u32, 4> params{};
+    usize param_count{};
+
+    /**
+     * The first private marker (like the `<` of SGR mouse reports) of the
+     * current control sequence.
+     */
+    char marker{};
+
+    /**
+     * The raw bytes of the current X10 mouse report.
+     */
+    array<u8, 3> x10{};
+    usize x10_count{};
+
+    /**
+     * How much of the end of paste marker was already seen.
+     */
+    usize paste_matched{};
+
+    /**
+     * The text of every paste of the batch, one after the other, and then of
+     * the one being received.
+     */
+    std::string paste_text;
+
+    /**
+     * Where each finished paste of the batch is in `paste_text`.
+     */
+    std::vector<std::pair<usize, usize>> pastes;
+
+    /**
+     * Where the paste being received starts in `paste_text`.
+     */
+    usize paste_start{};
+
+    /**
+     * How many bytes of the paste being received were dropped.
+     */
+    usize paste_dropped{};
+
+    Mouse mouse;
+
+    /**
+     * The events of the last `feed()`/`flush()`. Reused so that parsing does
+     * not allocate once it has grown.
+     */
+    std::vector<Event> events;
+};
+} // namespace uppr::eng
@@ -0,0 +1,104 @@
+#include "key-map.hpp"
+
+#include <algorithm>
+
+namespace uppr::eng {
+
+KeyMap::Handle KeyMap::add_listener(Event key, Listener l,
+                                    const Scene *owner) {
+    const auto slot = slot_of(key);
+    const auto id = next_id++;
+
+    Entry e{.id = id, .owner = owner, .listener = std::move(l)};
+
+    // The slot cant change while its listeners are being called
+    if (dispatching)
+        added.emplace_back(slot, std::move(e));
+    else
+        slots[slot].push_back(std::move(e));
+
+    return {static_cast<u32>(slot), id};
+}
+
+void KeyMap::remove_listener(Handle &h) {
+    if (!h) return;
+
+    auto &slot = slots[h.slot];
+    for (usize i{}; i < slot.size(); i++) {
+        if (slot[i].id != h.id) continue;
+
+        if (dispatching) {
+            // It may be the one running, so only forget about it for now
+            slot[i].id = 0;
+            stale.push_back(h.slot);
+        } else {
+            slot.erase(i);
+        }
+
+        h = {};
+        return;
+    }
+
+    const auto it = std::find_if(added.begin(), added.end(), [&](auto &a) {
+        return a.second.id == h.id;
+    });
+    if (it != added.end()) added.erase(it);
+
+    h = {};
+}
+
+void KeyMap::dispatch(Event e) {
+    auto &slot = slots[slot_of(e)];
+    const auto focused = get_focus();
+
+    dispatching = true;
+    for (usize i{}; i < slot.size(); i++) {
+        auto &entry = slot[i];
+        if (entry.id == 0) continue;
+        if (entry.owner && focused && entry.owner != focused) continue;
+
+        entry.listener(e);
+    }
+    dispatching = false;
+
+    if (!added.empty() || !stale.empty()) settle();
+}
+
+void KeyMap::pop_focus(const Scene *owner) {
+    const auto it = std::find(focus.rbegin(), focus.rend(), owner);
+    if (it != focus.rend()) focus.erase(std::next(it).base());
+}
+
+void KeyMap::settle() {
+    for (const auto s : stale) {
+        auto &slot = slots[s];
+        for (usize i{}; i < slot.size();) {
+            if (slot[i].id == 0)
+                slot.erase(i);
+            else
+                i++;
+        }
+    }
+    stale.clear();
+
+    for (auto &[s, e] : added) slots[s].push_back(std::move(e));
+    added.clear();
+}
+
+void KeyMap::Slot::push_back(Entry e) {
+    if (local_count < local.size())
+        local[local_count++] = std::move(e);
+    else
+        spill.push_back(std::move(e));
+}
+
+void KeyMap::Slot::erase(usize i) {
+    // Keep the order, the listeners run in the order that they were added
+    for (; i + 1 < size(); i++) (*this)[i] = std::move((*this)[i + 1]);
+
+    if (!spill.empty())
+        spill.pop_back();
+    else
+        local[--local_count] = {};
+}
+} // namespace uppr::eng
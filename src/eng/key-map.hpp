@@ -0,0 +1,153 @@
+#pragma once
+
+#include "commom.hpp"
+#include "event.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace uppr::eng {
+
+class Scene;
+
+/**
+ * Calls the listeners of each key.
+ *
+ * There is a slot for every possible event (one for each byte and one for
+ * each `Event::NonChar`), so finding the listeners of a key is indexing an
+ * array. The first few listeners of a slot are stored in the slot itself, as
+ * keys rarely have more than one or two.
+ *
+ * Listeners can belong to a scene. While some scene has the focus (see
+ * `push_focus()`), the listeners of other scenes are skipped, and only the
+ * ones of the focused scene and the ones that belong to no scene run. This is
+ * how a modal takes the keys from whatever is below it.
+ *
+ * Listeners can be added and removed from inside of other listeners. The ones
+ * added while a key is dispatched only get the keys after it.
+ */
+class KeyMap {
+public:
+    using Listener = std::function<void(Event)>;
+
+    /**
+     * Identifies a listener in order to remove it. A default constructed one
+     * identifies nothing.
+     */
+    struct Handle {
+        u32 slot{};
+        u32 id{};
+
+        constexpr explicit operator bool() const noexcept { return id != 0; }
+    };
+
+    /**
+     * How many listeners of a key are stored without allocating.
+     */
+    static constexpr usize inline_listeners = 2;
+
+    static constexpr usize slot_count =
+        256 + static_cast<usize>(Event::NonChar::count);
+
+public:
+    /**
+     * Call `l` every time that `key` is dispatched, and if `owner` is given,
+     * only while nothing else has the focus.
+     */
+    Handle add_listener(Event key, Listener l, const Scene *owner = nullptr);
+
+    /**
+     * Stop calling a listener, and reset the handle.
+     */
+    void remove_listener(Handle &h);
+
+    /**
+     * Call the listeners of `e`.
+     */
+    void dispatch(Event e);
+
+    /**
+     * Give the focus to `owner`, until it is `pop_focus()`ed.
+     */
+    void push_focus(const Scene *owner) { focus.push_back(owner); }
+
+    /**
+     * Take the focus from `owner`, giving it back to whoever had it before.
+     */
+    void pop_focus(const Scene *owner);
+
+    /**
+     * Get the scene that has the focus, or null if all of them do.
+     */
+    const Scene *get_focus() const noexcept {
+        return focus.empty() ? nullptr : focus.back();
+    }
+
+    /**
+     * Get the slot of `e`.
+     */
+    static constexpr usize slot_of(Event e) noexcept {
+        if (e.nch == Event::NonChar::none) return static_cast<uchar>(e.ch);
+        return 256 + static_cast<usize>(e.nch);
+    }
+
+private:
+    struct Entry {
+        /**
+         * Zero once removed, while it cant be erased yet.
+         */
+        u32 id{};
+
+        const Scene *owner{};
+
+        Listener listener;
+    };
+
+    /**
+     * The listeners of a key, the first `inline_listeners` of them in place.
+     */
+    struct Slot {
+        usize size() const noexcept { return local_count + spill.size(); }
+
+        Entry &operator[](usize i) {
+            return i < local_count ? local[i] : spill[i - local_count];
+        }
+
+        void push_back(Entry e);
+
+        void erase(usize i);
+
+        array<Entry, inline_listeners> local;
+        usize local_count{};
+
+        std::vector<Entry> spill;
+    };
+
+    /**
+     * Erase what was removed and add what was added during a dispatch.
+     */
+    void settle();
+
+private:
+    array<Slot, slot_count> slots;
+
+    /**
+     * Listeners added while dispatching, with their slots.
+     */
+    std::vector<std::pair<usize, Entry>> added;
+
+    /**
+     * Slots that had listeners removed while dispatching.
+     */
+    std::vector<usize> stale;
+
+    /**
+     * Scenes that took the focus, the last one has it.
+     */
+    std::vector<const Scene *> focus;
+
+    u32 next_id{1};
+
+    bool dispatching{};
+};
+} // namespace uppr::eng
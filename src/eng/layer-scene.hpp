@@ -0,0 +1,89 @@
+#pragma once
+
+#include "scene.hpp"
+#include "surface.hpp"
+#include "vector2.hpp"
+#include <memory>
+
+namespace uppr::eng {
+
+/**
+ * A scene that draws its child into an off-screen layer, and only draws it
+ * again when the child says that it `needs_redraw()` (or when the space that
+ * it gets changes). Otherwise, the layer is just copied to the screen.
+ */
+class LayerScene : public Scene {
+public:
+    LayerScene(std::shared_ptr<Scene> child_scene) : child{child_scene} {}
+
+    void update(Engine &engine) override { child->run_update(engine); }
+
+    void draw(Engine &engine, term::Transform transform, term::Size size,
+              term::TermScreen &screen) override {
+        if (!valid || child->needs_redraw() || transform != origin ||
+            size != layer_size) {
+            screen.push_layer(layer, transform, size);
+            child->run_draw(engine, transform, size, screen);
+            screen.pop_layer();
+
+            origin = transform;
+            layer_size = size;
+            valid = true;
+            redrawn = true;
+        }
+
+        screen.blit(layer);
+    }
+
+    void damage(term::Rect area, term::TermScreen &screen) override {
+        // Blitting the same layer again changes nothing
+        if (redrawn) screen.damage(area);
+        redrawn = false;
+    }
+
+    bool needs_redraw() const override {
+        return !valid || child->needs_redraw();
+    }
+
+    void mount(Engine &engine) override {
+        valid = false;
+        child->mount(engine);
+    }
+
+    void unmount(Engine &engine) override { child->unmount(engine); }
+
+    /**
+     * Forget what was drawn, so that the child is drawn again on the next
+     * frame.
+     */
+    void invalidate() { valid = false; }
+
+    static std::shared_ptr<LayerScene> make(std::shared_ptr<Scene> child) {
+        return std::make_shared<LayerScene>(child);
+    }
+
+private:
+    std::shared_ptr<Scene> child;
+
+    /**
+     * What the child drew last time.
+     */
+    term::Surface layer;
+
+    /**
+     * Where the child was drawn last time.
+     */
+    term::Transform origin;
+    term::Size layer_size;
+
+    /**
+     * If `layer` has anything useful in it.
+     */
+    bool valid{};
+
+    /**
+     * If `layer` was drawn again since the last `damage()`.
+     */
+    bool redrawn{};
+};
+} // namespace uppr::eng
@@ -0,0 +1,225 @@
+#include "line-edit.hpp"
+#include "key.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+
+namespace uppr::eng {
+
+namespace {
+
+/**
+ * How many bytes the UTF-8 sequence that starts with `lead` has, or 0 if it
+ * does not start one.
+ */
+constexpr usize utf8_length(uchar lead) noexcept {
+    if (lead < 0x80) return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+
+    return 0;
+}
+
+constexpr bool is_continuation(char c) noexcept {
+    return (static_cast<uchar>(c) & 0xC0) == 0x80;
+}
+
+/**
+ * Shown in place of line breaks.
+ */
+constexpr auto newline_glyph = U'↵';
+} // namespace
+
+bool LineEdit::handle(Event e) {
+    using Key = Event::NonChar;
+
+    switch (e.nch) {
+    case Key::left: cursor = prev_char(cursor); break;
+    case Key::right: cursor = next_char(cursor); break;
+    case Key::home: cursor = 0; break;
+    case Key::end: cursor = text.size(); break;
+    case Key::del: erase(cursor, next_char(cursor)); break;
+    case Key::up:
+        if (history_idx > 0) browse_history(history_idx - 1);
+        break;
+    case Key::down:
+        if (history_idx < history.size()) browse_history(history_idx + 1);
+        break;
+    case Key::none: {
+        const auto c = e.ch;
+
+        if (c == 0x7F || c == term::ctrl('h')) {
+            erase(prev_char(cursor), cursor);
+        } else if (c == term::ctrl('a')) {
+            cursor = 0;
+        } else if (c == term::ctrl('e')) {
+            cursor = text.size();
+        } else if (c == term::ctrl('w')) {
+            erase(prev_word(), cursor);
+        } else if (c == term::ctrl('u')) {
+            erase(0, cursor);
+        } else if (c == term::ctrl('k')) {
+            erase(cursor, text.size());
+        } else if (static_cast<uchar>(c) >= 0x20) {
+            // Collect the bytes of a character until it is complete, anything
+            // invalid is thrown away
+            if (is_continuation(c) && partial_size == 0) return true;
+            if (!is_continuation(c)) partial_size = 0;
+
+            partial[partial_size++] = c;
+
+            const auto length = utf8_length(partial[0]);
+            if (length == 0) {
+                partial_size = 0;
+            } else if (partial_size == length) {
+                insert_char({partial.data(), partial_size});
+                partial_size = 0;
+            }
+
+            return true;
+        } else {
+            return false;
+        }
+    } break;
+    default: return false;
+    }
+
+    touch();
+    return true;
+}
+
+void LineEdit::insert(string_view s) {
+    partial_size = 0;
+
+    while (!s.empty()) {
+        const auto [c, n] = term::decode_utf8(s);
+        const auto bytes = s.substr(0, n);
+        s.remove_prefix(n);
+
+        if (c == term::replacement_char && n == 1) continue;
+
+        // Other control characters would mess up the screen
+        if (c == '\r' || c == '\n')
+            insert_char("\n");
+        else if (c >= 0x20 && c != 0x7F)
+            insert_char(bytes);
+    }
+}
+
+std::string LineEdit::submit() {
+    auto result = std::move(text);
+
+    if (!result.empty() && (history.empty() || history.back() != result))
+        history.push_back(result);
+
+    draft.clear();
+    history_idx = history.size();
+    set_text({});
+
+    return result;
+}
+
+void LineEdit::set_text(string_view s) {
+    text = s.substr(0, max_size);
+    cursor = text.size();
+    while (cursor > 0 && cursor < s.size() && is_continuation(s[cursor]))
+        cursor--;
+    text.resize(cursor);
+
+    partial_size = 0;
+    touch();
+}
+
+void LineEdit::draw(term::Canvas canvas, term::PackedStyle style,
+                    bool show_cursor) {
+    const auto width = canvas.get_size().getx();
+    if (width == 0) return;
+
+    // Columns are characters, find the one where the cursor is
+    usize cursor_col{};
+    for (usize i{}; i < cursor; i++) cursor_col += !is_continuation(text[i]);
+
+    // Scroll just enough to have the cursor inside, with room for it at the
+    // end
+    if (cursor_col < scroll) scroll = cursor_col;
+    if (cursor_col >= scroll + width) scroll = cursor_col - width + 1;
+
+    const auto cursor_style = term::PackedStyle{
+        style.to_text_style() | fmt::emphasis::reverse};
+
+    canvas.fill({{}, {width, 1}}, {U' ', style});
+
+    usize col{};
+    string_view rest{text};
+    while (!rest.empty() && col < scroll + width) {
+        const auto [c, n] = term::decode_utf8(rest);
+        rest.remove_prefix(n);
+
+        if (col >= scroll) {
+            const auto is_cursor = show_cursor && col == cursor_col;
+            canvas.setc(static_cast<int>(col - scroll), 0,
+                        {c == '\n' ? newline_glyph : c,
+                         is_cursor ? cursor_style : style});
+        }
+
+        col++;
+    }
+
+    // At the end the cursor is after the text
+    if (show_cursor && cursor == text.size())
+        canvas.setc(static_cast<int>(cursor_col - scroll), 0,
+                    {U' ', cursor_style});
+}
+
+void LineEdit::insert_char(string_view c) {
+    if (text.size() + c.size() > max_size) return;
+
+    text.insert(cursor, c);
+    cursor += c.size();
+    touch();
+}
+
+void LineEdit::erase(usize from, usize to) {
+    text.erase(from, to - from);
+    cursor = from;
+}
+
+usize LineEdit::prev_char(usize pos) const {
+    if (pos == 0) return 0;
+
+    do {
+        pos--;
+    } while (pos > 0 && is_continuation(text[pos]));
+
+    return pos;
+}
+
+usize LineEdit::next_char(usize pos) const {
+    if (pos >= text.size()) return text.size();
+
+    do {
+        pos++;
+    } while (pos < text.size() && is_continuation(text[pos]));
+
+    return pos;
+}
+
+usize LineEdit::prev_word() const {
+    auto pos = cursor;
+
+    // Skip the spaces right before the cursor, and then the word
+    while (pos > 0 && text[pos - 1] == ' ') pos--;
+    while (pos > 0 && text[pos - 1] != ' ') pos--;
+
+    return pos;
+}
+
+void LineEdit::browse_history(usize idx) {
+    if (history_idx == history.size()) draft = text;
+
+    history_idx = idx;
+    set_text(idx < history.size() ? string_view{history[idx]}
+                                  : string_view{draft});
+}
+} // namespace uppr::eng
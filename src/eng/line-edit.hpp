@@ -0,0 +1,153 @@
+#pragma once
+
+#include "canvas.hpp"
+#include "commom.hpp"
+#include "event.hpp"
+#include "style.hpp"
+
+#include <string>
+#include <vector>
+
+namespace uppr::eng {
+
+/**
+ * A single line of editable UTF-8 text, driven by key events and drawn
+ * through a `term::Canvas`.
+ *
+ * The keys that it knows are:
+ * - left/right, home/end (and ctrl+a/ctrl+e) to move the cursor;
+ * - backspace and delete, ctrl+w for the word before the cursor, ctrl+u and
+ *   ctrl+k for everything before/after it;
+ * - up/down to go through the history of what was `submit()`ted.
+ *
+ * Everything printable is inserted at the cursor. Multi-byte characters come
+ * in one event per byte, and are inserted once they are complete. Line breaks
+ * (from pastes) are kept, and shown as `↵`.
+ */
+class LineEdit {
+public:
+    /**
+     * Create an editor that holds at most `max_size` bytes.
+     */
+    explicit LineEdit(usize max_size) : max_size{max_size} {}
+
+public:
+    /**
+     * Handle a key.
+     *
+     * @return If the key was one that the editor knows.
+     */
+    bool handle(Event e);
+
+    /**
+     * Insert `text` at the cursor, as much of it as fits.
+     */
+    void insert(string_view text);
+
+    /**
+     * Take the text out of the editor, remembering it in the history.
+     */
+    std::string submit();
+
+    /**
+     * Replace the text, with the cursor at the end.
+     */
+    void set_text(string_view text);
+
+    /**
+     * Remove all of the text.
+     */
+    void clear() { set_text({}); }
+
+    string_view get_text() const noexcept { return text; }
+
+    bool empty() const noexcept { return text.empty(); }
+
+    /**
+     * Get where the cursor is, in bytes.
+     */
+    usize get_cursor() const noexcept { return cursor; }
+
+    /**
+     * A counter that changes every time that the text or the cursor change,
+     * to know when it has to be drawn again.
+     */
+    u64 get_generation() const noexcept { return generation; }
+
+    /**
+     * Draw the text on the first line of `canvas`, scrolled so that the
+     * cursor is always visible. The cursor is only shown if `show_cursor`.
+     */
+    void draw(term::Canvas canvas, term::PackedStyle style,
+              bool show_cursor = true);
+
+private:
+    /**
+     * Insert a single complete character.
+     */
+    void insert_char(string_view c);
+
+    /**
+     * Erase the bytes from `from` up to `to`, leaving the cursor at `from`.
+     */
+    void erase(usize from, usize to);
+
+    /**
+     * Get where the character before/after `pos` starts.
+     */
+    usize prev_char(usize pos) const;
+    usize next_char(usize pos) const;
+
+    /**
+     * Get where the word before the cursor starts.
+     */
+    usize prev_word() const;
+
+    /**
+     * Show the entry `idx` of the history, or the draft if it is past the
+     * end.
+     */
+    void browse_history(usize idx);
+
+    void touch() { generation++; }
+
+private:
+    std::string text;
+
+    /**
+     * Byte offset of the cursor, always at the start of a character.
+     */
+    usize cursor{};
+
+    usize max_size;
+
+    /**
+     * The bytes of a character that did not arrive completely yet.
+     */
+    array<char, 4> partial{};
+    usize partial_size{};
+
+    /**
+     * Everything that was submitted, oldest first.
+     */
+    std::vector<std::string> history;
+
+    /**
+     * The entry of the history being shown, `history.size()` if none.
+     */
+    usize history_idx{};
+
+    /**
+     * What was being written before going through the history.
+     */
+    std::string draft;
+
+    /**
+     * The first column that is visible, kept between draws so that the text
+     * does not jump around.
+     */
+    usize scroll{};
+
+    u64 generation{};
+};
+} // namespace uppr::eng
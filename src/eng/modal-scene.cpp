@@ -3,7 +3,7 @@
 namespace uppr::eng {
 
 void ModalScene::update(Engine &engine) {
-    if (modal && should_show_modal) modal->update(engine);
+    if (modal && should_show_modal) modal->run_update(engine);
 }
 
 void ModalScene::draw(Engine &engine, term::Transform transform,
@@ -11,22 +11,43 @@ void ModalScene::draw(Engine &engine, term::Transform transform,
     if (modal && should_show_modal) {
         transform += origin;
 
-        const auto one_third = size.getx() / 3;
-        const auto one_quarter = size.gety() / 4;
-        const auto on_half = one_quarter * 2;
+        const auto rect = modal_rect(size);
+        modal->run_draw(engine, rect.tl, rect.size, screen);
+    }
+}
 
-        const term::Transform newt{static_cast<int>(one_third),
-                                   static_cast<int>(one_quarter)};
-        const term::Size news{one_third, on_half};
+void ModalScene::damage(term::Rect area, term::TermScreen &screen) {
+    const auto rect = modal_rect(area.size).intersect(area);
 
-        modal->draw(engine, newt, news, screen);
+    // Showing or hiding changes everything that the modal covers, which goes
+    // one past its size for the right and bottom edges of its box (see
+    // `TermScreen::box()`)
+    if (should_show_modal != damaged_showing) {
+        const auto r = modal_rect(area.size);
+        screen.damage(term::Rect{r.tl, r.size + 1}.intersect(area));
+        damaged_showing = should_show_modal;
+    } else if (modal && should_show_modal) {
+        modal->damage(rect, screen);
     }
 }
 
+term::Rect ModalScene::modal_rect(term::Size size) const {
+    const auto one_third = size.getx() / 3;
+    const auto one_quarter = size.gety() / 4;
+    const auto on_half = one_quarter * 2;
+
+    const term::Transform newt{static_cast<int>(one_third),
+                               static_cast<int>(one_quarter)};
+    const term::Size news{one_third, on_half};
+
+    return {newt, news};
+}
+
 void ModalScene::mount(Engine &engine) {
     if (should_show_modal && !modal_mounted) {
         modal->mount(engine);
         modal_mounted = true;
+        engine.get_keymap().push_focus(modal.get());
     }
 }
 
@@ -34,6 +55,7 @@ void ModalScene::unmount(Engine &engine) {
     if (should_show_modal && modal_mounted) {
         modal->unmount(engine);
         modal_mounted = false;
+        engine.get_keymap().pop_focus(modal.get());
     }
 }
 
@@ -41,6 +63,7 @@ void ModalScene::show_modal(Engine &engine) {
     if (!should_show_modal && !modal_mounted) {
         modal->mount(engine);
         modal_mounted = true;
+        engine.get_keymap().push_focus(modal.get());
     }
 
     should_show_modal = true;
@@ -50,6 +73,7 @@ void ModalScene::hide_modal(Engine &engine) {
     if (should_show_modal && modal_mounted) {
         modal->unmount(engine);
         modal_mounted = false;
+        engine.get_keymap().pop_focus(modal.get());
     }
 
     should_show_modal = false;
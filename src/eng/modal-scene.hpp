@@ -8,7 +8,8 @@
 namespace uppr::eng {
 
 /**
- * This scene shows another one if requested via a flag.
+ * This scene shows another one if requested via a flag. While it is shown,
+ * the other scene has the focus of the key map (see `KeyMap::push_focus()`).
  */
 class ModalScene : public Scene {
 public:
@@ -20,6 +21,8 @@ public:
     void draw(Engine &engine, term::Transform transform, term::Size size,
               term::TermScreen &screen) override;
 
+    void damage(term::Rect area, term::TermScreen &screen) override;
+
     void mount(Engine &engine) override;
 
     void unmount(Engine &engine) override;
@@ -38,6 +41,12 @@ public:
         return std::make_shared<ModalScene>(m, t);
     }
 
+private:
+    /**
+     * Where the modal is drawn inside of the given rectangle.
+     */
+    term::Rect modal_rect(term::Size size) const;
+
 private:
     /**
      * The modal popup scene.
@@ -58,5 +67,10 @@ private:
      * If the modal has been mounted.
      */
     bool modal_mounted{};
+
+    /**
+     * If the modal was showing on the last `damage()`.
+     */
+    bool damaged_showing{};
 };
 } // namespace uppr::eng
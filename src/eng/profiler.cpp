@@ -0,0 +1,178 @@
+#include "profiler.hpp"
+#include "fmt/format.h"
+#include "scene.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <typeinfo>
+
+namespace uppr::eng {
+
+namespace {
+
+/**
+ * Get the name of the class of `scene`, without namespaces.
+ */
+std::string scene_name(const Scene &scene) {
+    const auto mangled = typeid(scene).name();
+
+    int status{};
+    char *demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : mangled;
+    std::free(demangled);
+
+    if (const auto colons = name.rfind("::"); colons != std::string::npos)
+        name.erase(0, colons + 2);
+
+    return name;
+}
+
+constexpr double to_ms(u64 nanos) { return nanos / 1e6; }
+
+/**
+ * Columns for the names, so that the times line up.
+ */
+constexpr usize name_width = 28;
+
+void append_name(std::string &out, usize depth, string_view name) {
+    const auto indent = depth * 2;
+    fmt::format_to(std::back_inserter(out), "{:{}}{:<{}}", "", indent, name,
+                   indent < name_width ? name_width - indent : 0);
+}
+} // namespace
+
+Profiler::Profiler() {
+    nodes.push_back({.name = trace::intern("frame")});
+}
+
+void Profiler::begin_frame() {
+    current = 0;
+    frame_start = Clock::now();
+}
+
+void Profiler::end_frame(std::chrono::microseconds budget) {
+    using namespace std::chrono;
+
+    leave(0, frame_start, Clock::now());
+
+    for (auto &n : nodes) {
+        n.last = n.ran ? n.frame : 0;
+        if (n.ran) {
+            n.samples[n.sample_count++ % window] =
+                static_cast<u32>(std::min<u64>(n.frame, UINT32_MAX));
+        }
+
+        n.frame = 0;
+        n.ran = false;
+    }
+
+    if (nodes[0].last > static_cast<u64>(nanoseconds{budget}.count())) {
+        std::string tree;
+        format_tree(tree, 0);
+
+        LOG_F(WARNING, "Frame took {:.2f}ms of {:.2f}ms:\n{}",
+              to_ms(nodes[0].last), budget.count() / 1e3, tree);
+    }
+}
+
+void Profiler::log_summary() const {
+    std::string out;
+    for (usize i{}; i < nodes.size(); i++) {
+        const auto s = get_stats(i);
+        append_name(out, nodes[i].depth, nodes[i].name);
+        fmt::format_to(std::back_inserter(out),
+                       " mean {:7.3f}ms p50 {:7.3f}ms p99 {:7.3f}ms "
+                       "max {:7.3f}ms\n",
+                       to_ms(s.mean), to_ms(s.p50), to_ms(s.p99),
+                       to_ms(s.max));
+    }
+
+    LOG_F(INFO, "Time per frame, over the last {} frames:\n{}", window, out);
+}
+
+Profiler::Stats Profiler::get_stats(usize node) const {
+    const auto &n = nodes[node];
+    const auto count = std::min(n.sample_count, window);
+    if (count == 0) return {};
+
+    array<u32, window> sorted;
+    std::copy_n(n.samples.begin(), count, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + count);
+
+    u64 total{};
+    for (usize i{}; i < count; i++) total += sorted[i];
+
+    // Nearest rank
+    const auto rank = [&](usize percent) {
+        return sorted[(count * percent + 99) / 100 - 1];
+    };
+
+    return {.mean = total / count,
+            .p50 = rank(50),
+            .p99 = rank(99),
+            .max = sorted[count - 1],
+            .count = count};
+}
+
+usize Profiler::enter(const void *key, string_view name) {
+    auto node = find_child(key);
+    if (node == 0) node = add_child(key, name);
+
+    current = node;
+    return node;
+}
+
+usize Profiler::enter(const Scene &scene) {
+    // Only look up the name the first time, it is not cheap
+    auto node = find_child(&scene);
+    if (node == 0) node = add_child(&scene, scene_name(scene));
+
+    current = node;
+    return node;
+}
+
+void Profiler::leave(usize node, Clock::time_point start,
+                     Clock::time_point end) {
+    auto &n = nodes[node];
+    n.frame +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count();
+    n.ran = true;
+
+    current = n.parent;
+
+    if (trace::enabled()) trace::record(n.name, "frame", start, end);
+}
+
+usize Profiler::find_child(const void *key) const {
+    for (const auto child : nodes[current].children) {
+        if (nodes[child].key == key) return child;
+    }
+
+    return 0;
+}
+
+usize Profiler::add_child(const void *key, string_view name) {
+    const auto node = nodes.size();
+    nodes.push_back({.key = key,
+                     .name = trace::intern(name),
+                     .parent = current,
+                     .depth = nodes[current].depth + 1});
+    nodes[current].children.push_back(node);
+
+    return node;
+}
+
+void Profiler::format_tree(std::string &out, usize node) const {
+    const auto &n = nodes[node];
+    if (n.last == 0) return;
+
+    append_name(out, n.depth, n.name);
+    fmt::format_to(std::back_inserter(out), " {:7.3f}ms (p99 {:.3f}ms)\n",
+                   to_ms(n.last), to_ms(get_stats(node).p99));
+
+    for (const auto child : n.children) format_tree(out, child);
+}
+} // namespace uppr::eng
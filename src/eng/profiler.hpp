@@ -0,0 +1,187 @@
+#pragma once
+
+#include "commom.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace uppr::eng {
+
+class Scene;
+
+/**
+ * Times what each frame is spent on, as a tree.
+ *
+ * Code to be timed is wrapped in a `Scope`, and scopes that are inside of
+ * others become their children. The engine opens one for each part of the
+ * frame (reading input, update, draw and so on) and `Scene::run_update()` and
+ * `Scene::run_draw()` open one for each scene, so the tree follows the scene
+ * tree.
+ *
+ * Each node keeps the times of the last `window` frames that it ran on, to
+ * get rolling statistics from. When a frame takes longer than its budget, the
+ * tree of that frame is logged, to know what took the time. While tracing
+ * (see `trace::Session`), every scope is also a span of the trace.
+ */
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * How many frames the statistics are about.
+     */
+    static constexpr usize window = 128;
+
+    /**
+     * Statistics about a node, over the last `window` frames that it ran on.
+     * Times are in nanoseconds.
+     */
+    struct Stats {
+        u64 mean{};
+        u64 p50{};
+        u64 p99{};
+        u64 max{};
+
+        /**
+         * How many frames these are about.
+         */
+        usize count{};
+    };
+
+    /**
+     * Times from its construction to its destruction, under the scope that
+     * was open when it was created.
+     */
+    class Scope {
+    public:
+        /**
+         * Time a part of the frame. `name` identifies it (by its address), so
+         * it should be a string literal.
+         */
+        Scope(Profiler &p, string_view name)
+            : profiler{p}, node{p.enter(name.data(), name)},
+              start{Clock::now()} {}
+
+        /**
+         * Time something that `scene` does.
+         */
+        Scope(Profiler &p, const Scene &scene)
+            : profiler{p}, node{p.enter(scene)}, start{Clock::now()} {}
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope() { profiler.leave(node, start, Clock::now()); }
+
+    private:
+        Profiler &profiler;
+        usize node;
+        Clock::time_point start;
+    };
+
+public:
+    Profiler();
+
+    /**
+     * Start timing a frame.
+     */
+    void begin_frame();
+
+    /**
+     * Finish the frame, logging what it was spent on if it took longer than
+     * `budget`.
+     */
+    void end_frame(std::chrono::microseconds budget);
+
+    /**
+     * Log the statistics of every node.
+     */
+    void log_summary() const;
+
+    /**
+     * How many nodes there are. The first one is the whole frame, and every
+     * node comes after its parent.
+     */
+    usize size() const noexcept { return nodes.size(); }
+
+    string_view get_name(usize node) const { return nodes[node].name; }
+
+    /**
+     * How deep in the tree a node is, zero for the frame.
+     */
+    usize get_depth(usize node) const { return nodes[node].depth; }
+
+    /**
+     * How long a node took on the last frame, in nanoseconds, or zero if it
+     * did not run.
+     */
+    u64 get_last(usize node) const { return nodes[node].last; }
+
+    Stats get_stats(usize node) const;
+
+private:
+    struct Node {
+        /**
+         * Tells apart the children of the same node.
+         */
+        const void *key{};
+
+        /**
+         * From `trace::intern()`, so that spans can use it.
+         */
+        const char *name{};
+
+        usize parent{};
+        usize depth{};
+
+        std::vector<usize> children;
+
+        /**
+         * Time spent on the current frame, in nanoseconds.
+         */
+        u64 frame{};
+
+        /**
+         * Time spent on the last frame, in nanoseconds.
+         */
+        u64 last{};
+
+        bool ran{};
+
+        /**
+         * The last times, as a ring.
+         */
+        array<u32, window> samples{};
+        usize sample_count{};
+    };
+
+    usize enter(const void *key, string_view name);
+
+    usize enter(const Scene &scene);
+
+    void leave(usize node, Clock::time_point start, Clock::time_point end);
+
+    /**
+     * Find the child of the current node for `key`, or 0 if it is new.
+     */
+    usize find_child(const void *key) const;
+
+    usize add_child(const void *key, string_view name);
+
+    /**
+     * Write a node and everything below it, as it was on the last frame.
+     */
+    void format_tree(std::string &out, usize node) const;
+
+private:
+    std::vector<Node> nodes;
+
+    /**
+     * The node of the innermost open scope.
+     */
+    usize current{};
+
+    Clock::time_point frame_start;
+};
+} // namespace uppr::eng
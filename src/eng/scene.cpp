@@ -0,0 +1,16 @@
+#include "scene.hpp"
+#include "engine.hpp"
+
+namespace uppr::eng {
+
+void Scene::run_update(Engine &engine) {
+    const Profiler::Scope scope{engine.get_profiler(), *this};
+    update(engine);
+}
+
+void Scene::run_draw(Engine &engine, term::Transform transform,
+                     term::Size size, term::TermScreen &screen) {
+    const Profiler::Scope scope{engine.get_profiler(), *this};
+    draw(engine, transform, size, screen);
+}
+} // namespace uppr::eng
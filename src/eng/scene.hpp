@@ -16,6 +16,20 @@ class Scene {
 public:
     virtual ~Scene() {}
 
+    /**
+     * Call `update`, timing it in the profiler of the engine (see
+     * `Engine::get_profiler()`). Scenes with children should update them
+     * with this.
+     */
+    void run_update(Engine &engine);
+
+    /**
+     * Call `draw`, timing it in the profiler of the engine. Scenes with
+     * children should draw them with this.
+     */
+    void run_draw(Engine &engine, term::Transform transform, term::Size size,
+                  term::TermScreen &screen);
+
     /**
      * Function to run the current frame.
      */
@@ -27,6 +41,26 @@ public:
     virtual void draw(Engine &engine, term::Transform transform, term::Size size,
                       term::TermScreen &screen) = 0;
 
+    /**
+     * Tell the screen which parts of `area` changed on the last `draw`, with
+     * `TermScreen::damage()`. Only those are sent to the terminal.
+     *
+     * This is called right after `draw`, with the same rectangle. Containers
+     * should pass it on to their children, clipped to where each child was
+     * drawn. The default is to damage all of `area`, which is always correct.
+     */
+    virtual void damage(term::Rect area, term::TermScreen &screen) {
+        screen.damage(area);
+    }
+
+    /**
+     * If what `draw` would produce changed since the last time it was called.
+     *
+     * This is used by `LayerScene` to reuse what was drawn before. The default
+     * is to always redraw, which is always correct.
+     */
+    virtual bool needs_redraw() const { return true; }
+
     /**
      * Called when the scene becomes the active scene in the engine.
      */
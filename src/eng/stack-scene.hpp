@@ -15,7 +15,7 @@ class StackScene : public Scene {
 public:
     void update(Engine &engine) override {
         for (const auto &[_, child] : children) {
-            child->update(engine);
+            child->run_update(engine);
         }
     }
 
@@ -24,7 +24,15 @@ public:
         transform += origin;
 
         for (const auto &[_, child] : children) {
-            child->draw(engine, transform, size, screen);
+            child->run_draw(engine, transform, size, screen);
+        }
+    }
+
+    void damage(term::Rect area, term::TermScreen &screen) override {
+        const term::Rect moved{area.tl + origin, area.size};
+
+        for (const auto &[_, child] : children) {
+            child->damage(moved.intersect(area), screen);
         }
     }
 
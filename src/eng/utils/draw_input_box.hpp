@@ -54,4 +54,19 @@ term::Transform draw_basic_button(T item_kind, T selected_kind, bool disabled,
 
     return transform;
 }
+
+/**
+ * Get what should go into an input field when `text` is pasted there: only
+ * the first line, and only as many bytes as typing would allow (without
+ * cutting a character in half).
+ */
+inline std::string field_from_paste(string_view text, usize max_lenght = 28) {
+    text = text.substr(0, text.find_first_of("\r\n"));
+    if (text.size() <= max_lenght) return std::string{text};
+
+    auto n = max_lenght;
+    while (n > 0 && (static_cast<uchar>(text[n]) & 0xC0) == 0x80) n--;
+
+    return std::string{text.substr(0, n)};
+}
 } // namespace uppr::app
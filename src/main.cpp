@@ -22,6 +22,8 @@
 
 #include "db/conn.hpp"
 #include "os/file.hpp"
+#include "os/metrics.hpp"
+#include "os/trace.hpp"
 #include "state.hpp"
 #include "term/key.hpp"
 #include "term/term.hpp"
@@ -46,11 +48,39 @@ int main(int argc, char **argv) {
                      loguru::Verbosity_8);
     loguru::init(argc, argv);
 
+    // Latency percentiles go next to the log, every 10s unless said otherwise
+    const auto env_metrics_interval = std::getenv("METRICS_INTERVAL");
+    const uppr::metrics::Dumper metrics_dumper{
+        fmt::format("metrics{}.log", actual_port),
+        std::chrono::seconds{
+            env_metrics_interval ? std::stoi(env_metrics_interval) : 10}};
+
+    // Record a trace of what every thread does, for chrome://tracing or
+    // Perfetto, if asked to (it is written on exit and with F12)
+    const auto env_trace = std::getenv("TRACE_FILE");
+    std::optional<uppr::trace::Session> trace_session;
+    if (env_trace) trace_session.emplace(env_trace);
+
     term = std::make_shared<uppr::term::TermScreen>(fileno(stdin), stdout);
     signal(SIGWINCH, handle_winch);
 
+    // Commit frames from a separate thread, so a slow terminal doesn't stall
+    // input and networking
+    const auto env_render_thread = std::getenv("RENDER_THREAD");
+    if (env_render_thread && std::string_view{env_render_thread} == "1")
+        term->start_render_thread();
+
+    // The most FPS, when typing or receiving, and the FPS when idle
+    const auto env_fps = std::getenv("FPS");
+    const auto env_idle_fps = std::getenv("IDLE_FPS");
+    const auto actual_fps = env_fps ? std::stoi(env_fps) : 30;
+    const auto actual_idle_fps =
+        env_idle_fps ? std::stoi(env_idle_fps)
+                     : uppr::eng::FrameScheduler::default_idle_fps;
+
     try {
-        uppr::app::start_app(term, actual_port, actual_name);
+        uppr::app::start_app(term, actual_port, actual_name, actual_fps,
+                             actual_idle_fps);
     } catch (const uppr::db::DatabaseError &e) {
         LOG_F(ERROR, "Database error: [{}, {}]", e.what(),
               e.get_result().str());
@@ -60,10 +90,7 @@ int main(int argc, char **argv) {
 }
 
 void handle_winch(int sig) {
-    signal(SIGWINCH, SIG_IGN);
-
-    // Reinitialize the window to update data structures.
-    term->update_size();
-
-    signal(SIGWINCH, handle_winch);
+    // The engine does the actual resize at the start of the next frame, as
+    // almost nothing is safe to do from here.
+    term->notify_resize();
 }
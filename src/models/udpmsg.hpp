@@ -5,6 +5,12 @@
 namespace uppr::models {
 
 struct UdpMessage {
+    /**
+     * The most bytes that a packed message can have. Small enough that a
+     * datagram is never fragmented, bigger messages have to be split.
+     */
+    static constexpr usize max_wire_size = 1200;
+
     std::string content;
     std::string sent_by;   // name of who sent the message
     std::string sent_from; // name of the chat where the message was sent to
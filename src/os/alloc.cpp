@@ -0,0 +1,31 @@
+#include "alloc.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace uppr::alloc {
+
+namespace {
+
+/**
+ * Per thread, so that counting does not need any synchronization and a
+ * thread only sees what it allocated itself.
+ */
+thread_local usize allocations{};
+} // namespace
+
+usize thread_count() noexcept { return allocations; }
+} // namespace uppr::alloc
+
+// The array and `nothrow` versions all end up calling this one
+void *operator new(std::size_t size) {
+    uppr::alloc::allocations++;
+
+    if (const auto p = std::malloc(size ? size : 1)) return p;
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
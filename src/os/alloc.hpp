@@ -0,0 +1,15 @@
+#pragma once
+
+#include "commom.hpp"
+
+namespace uppr::alloc {
+
+/**
+ * Number of heap allocations (`operator new`) done by the calling thread so
+ * far.
+ *
+ * The global `operator new` is replaced to keep this count, so take the
+ * difference before and after something to see how much it allocates.
+ */
+usize thread_count() noexcept;
+} // namespace uppr::alloc
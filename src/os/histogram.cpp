@@ -0,0 +1,46 @@
+#include "histogram.hpp"
+
+namespace uppr::os {
+
+Histogram::Summary Histogram::summarize() const noexcept {
+    // Take a copy first, so that everything is about the same values even if
+    // something is recorded meanwhile
+    array<u64, bucket_count> copy;
+    u64 count{};
+    for (usize i{}; i < bucket_count; i++) {
+        copy[i] = counts[i].load(std::memory_order_relaxed);
+        count += copy[i];
+    }
+
+    Summary s{.count = count};
+    if (count == 0) return s;
+
+    // Nearest rank of each percentile, in order
+    const auto rank = [&](u64 permille) {
+        return std::max<u64>((count * permille + 999) / 1000, 1);
+    };
+    const array<std::pair<u64, u64 *>, 4> targets{{
+        {rank(500), &s.p50},
+        {rank(900), &s.p90},
+        {rank(990), &s.p99},
+        {rank(999), &s.p999},
+    }};
+
+    usize next{};
+    u64 seen{};
+    u64 total{};
+    for (usize i{}; i < bucket_count; i++) {
+        if (copy[i] == 0) continue;
+
+        seen += copy[i];
+        total += copy[i] * middle_of(i);
+        s.max = middle_of(i);
+
+        while (next < targets.size() && seen >= targets[next].first)
+            *targets[next++].second = middle_of(i);
+    }
+
+    s.mean = total / count;
+    return s;
+}
+} // namespace uppr::os
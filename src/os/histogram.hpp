@@ -0,0 +1,98 @@
+#pragma once
+
+#include "commom.hpp"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+
+namespace uppr::os {
+
+/**
+ * A histogram of non-negative values (like latencies in nanoseconds), in the
+ * style of HdrHistogram.
+ *
+ * Values below `sub_buckets` have a bucket each. Above that, every power of
+ * two is split into `sub_buckets / 2` buckets, so the value of a bucket is
+ * always within about 3% of what was recorded, for anything that fits in 64
+ * bits. It never allocates, and takes `bucket_count` counters.
+ *
+ * Recording is a single relaxed atomic increment, so it can be done from any
+ * thread without locking and is cheap enough to be always on. Reading while
+ * others record gives a consistent enough picture for statistics.
+ */
+class Histogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 6;
+    static constexpr usize sub_buckets = usize{1} << sub_bucket_bits;
+    static constexpr usize half_buckets = sub_buckets / 2;
+
+    static constexpr usize bucket_count =
+        (64 - sub_bucket_bits) * half_buckets + sub_buckets;
+
+    /**
+     * Percentiles of everything recorded so far.
+     */
+    struct Summary {
+        u64 count{};
+        u64 mean{};
+        u64 p50{};
+        u64 p90{};
+        u64 p99{};
+        u64 p999{};
+        u64 max{};
+    };
+
+public:
+    void record(u64 value) noexcept {
+        counts[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Record a duration, in nanoseconds.
+     */
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) noexcept {
+        const auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        record(static_cast<u64>(std::max<decltype(ns)>(ns, 0)));
+    }
+
+    Summary summarize() const noexcept;
+
+    /**
+     * Get the bucket that `value` goes in.
+     */
+    static constexpr usize bucket_of(u64 value) noexcept {
+        if (value < sub_buckets) return value;
+
+        // Keep the top `sub_bucket_bits` bits
+        const auto shift = std::bit_width(value) - sub_bucket_bits;
+        return shift * half_buckets + (value >> shift);
+    }
+
+    /**
+     * Get the smallest value that goes in `bucket`.
+     */
+    static constexpr u64 lowest_of(usize bucket) noexcept {
+        if (bucket < sub_buckets) return bucket;
+
+        const auto shift = bucket / half_buckets - 1;
+        return static_cast<u64>(bucket - shift * half_buckets) << shift;
+    }
+
+    /**
+     * Get the value in the middle of `bucket`, which is what stands for all
+     * values in it.
+     */
+    static constexpr u64 middle_of(usize bucket) noexcept {
+        if (bucket < sub_buckets) return bucket;
+
+        const auto shift = bucket / half_buckets - 1;
+        return lowest_of(bucket) + (u64{1} << shift) / 2;
+    }
+
+private:
+    array<std::atomic<u64>, bucket_count> counts{};
+};
+} // namespace uppr::os
@@ -0,0 +1,114 @@
+#include "metrics.hpp"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace uppr::metrics {
+
+os::Histogram frame_time;
+os::Histogram commit_time;
+os::Histogram send_latency;
+os::Histogram db_step;
+
+Counter db_queries;
+Counter datagrams_received;
+Counter datagrams_sent;
+Counter frames_skipped;
+
+namespace {
+
+constexpr std::pair<string_view, const os::Histogram *> histograms[]{
+    {"frame_time", &frame_time},
+    {"commit_time", &commit_time},
+    {"send_latency", &send_latency},
+    {"db_step", &db_step},
+};
+
+constexpr std::pair<string_view, const Counter *> counters[]{
+    {"db_queries", &db_queries},
+    {"dgrams_in", &datagrams_received},
+    {"dgrams_out", &datagrams_sent},
+    {"frames_skip", &frames_skipped},
+};
+
+constexpr double to_us(u64 nanos) { return nanos / 1e3; }
+} // namespace
+
+usize resident_memory() {
+    // The second number is the resident pages
+    const auto file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+
+    unsigned long size{};
+    unsigned long resident{};
+    const auto n = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+
+    return n == 2 ? resident * static_cast<usize>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+Dumper::Dumper(const std::string &filename, std::chrono::seconds interval)
+    : file{std::fopen(filename.c_str(), "w")},
+      interval{std::max(interval, std::chrono::seconds{1})},
+      start{std::chrono::steady_clock::now()} {
+    if (!file) {
+        LOG_F(ERROR, "Could not open {}: {}", filename, strerror(errno));
+        return;
+    }
+
+    if (interval.count() <= 0)
+        LOG_F(WARNING, "Metrics interval of {}s, dumping every 1s instead",
+              interval.count());
+
+    thread = std::thread{[this] { run(); }};
+}
+
+Dumper::~Dumper() {
+    if (!file) return;
+
+    {
+        const std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    stop_cv.notify_one();
+    thread.join();
+
+    dump();
+    std::fclose(file);
+}
+
+void Dumper::run() {
+    loguru::set_thread_name("metrics");
+
+    std::unique_lock lock{mutex};
+    while (!stop_cv.wait_for(lock, interval, [this] { return stopping; }))
+        dump();
+}
+
+void Dumper::dump() {
+    using namespace std::chrono;
+
+    const auto elapsed = duration<double>(steady_clock::now() - start);
+    fmt::print(file, "# after {:.1f}s, in microseconds\n", elapsed.count());
+    fmt::print(file, "{:<14}{:>10}{:>10}{:>10}{:>10}{:>10}{:>10}{:>10}\n",
+               "name", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+
+    for (const auto &[name, h] : histograms) {
+        const auto s = h->summarize();
+        fmt::print(file,
+                   "{:<14}{:>10}{:>10.1f}{:>10.1f}{:>10.1f}{:>10.1f}{:>10.1f}"
+                   "{:>10.1f}\n",
+                   name, s.count, to_us(s.mean), to_us(s.p50), to_us(s.p90),
+                   to_us(s.p99), to_us(s.p999), to_us(s.max));
+    }
+
+    for (const auto &[name, c] : counters)
+        fmt::print(file, "{:<14}{:>10}\n", name, c->get());
+
+    fmt::print(file, "\n");
+    std::fflush(file);
+}
+} // namespace uppr::metrics
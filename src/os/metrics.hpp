@@ -0,0 +1,108 @@
+#pragma once
+
+#include "commom.hpp"
+#include "histogram.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace uppr::metrics {
+
+/**
+ * Counts how many times something happened. Like `os::Histogram`, adding is a
+ * single relaxed atomic increment.
+ */
+class Counter {
+public:
+    void add(u64 n = 1) noexcept {
+        value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    u64 get() const noexcept { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<u64> value{};
+};
+
+/**
+ * How long each frame took, from when it started until it was committed.
+ */
+extern os::Histogram frame_time;
+
+/**
+ * How long it took for frames to reach the terminal after being drawn.
+ */
+extern os::Histogram commit_time;
+
+/**
+ * How long it took from a message being pushed until it was sent, for each
+ * member of the chat that it was sent to.
+ */
+extern os::Histogram send_latency;
+
+/**
+ * How long each step of a database statement took (one for statements that
+ * dont return rows, and one per row for the ones that do).
+ */
+extern os::Histogram db_step;
+
+/**
+ * How many database statements were run (not how many steps they took).
+ */
+extern Counter db_queries;
+
+/**
+ * How many datagrams were received and sent.
+ */
+extern Counter datagrams_received;
+extern Counter datagrams_sent;
+
+/**
+ * How many frames skipped their draw to catch up (see
+ * `eng::FrameScheduler`).
+ */
+extern Counter frames_skipped;
+
+/**
+ * Get how much memory of the process is resident, in bytes, or zero if it
+ * cant be known.
+ */
+usize resident_memory();
+
+/**
+ * Writes the percentiles of every histogram to a file, every `interval`,
+ * from a thread of its own. The file is truncated when created, and every
+ * dump is added to the end of it, so that it shows how they change over
+ * time, followed by the counters. They are written a last time when it is
+ * destroyed. Intervals under a second are taken as one second.
+ */
+class Dumper {
+public:
+    Dumper(const std::string &filename, std::chrono::seconds interval);
+    ~Dumper();
+
+    Dumper(const Dumper &) = delete;
+    Dumper &operator=(const Dumper &) = delete;
+
+private:
+    void run();
+
+    void dump();
+
+private:
+    std::FILE *file;
+
+    std::chrono::seconds interval;
+
+    std::chrono::steady_clock::time_point start;
+
+    std::mutex mutex;
+    std::condition_variable stop_cv;
+    bool stopping{};
+
+    std::thread thread;
+};
+} // namespace uppr::metrics
@@ -0,0 +1,104 @@
+#include "reactor.hpp"
+#include "loguru.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace uppr::os {
+
+EventFd::EventFd() : fd{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+    if (fd < 0) LOG_F(FATAL, "Could not create eventfd: {}", strerror(errno));
+}
+
+EventFd::~EventFd() { close(fd); }
+
+void EventFd::signal() const noexcept {
+    const u64 one = 1;
+    [[maybe_unused]] const auto n = ::write(fd, &one, sizeof(one));
+}
+
+void EventFd::drain() const noexcept {
+    u64 count;
+    [[maybe_unused]] const auto n = ::read(fd, &count, sizeof(count));
+}
+
+Reactor::Reactor()
+    : epoll_fd{epoll_create1(EPOLL_CLOEXEC)},
+      timer_fd{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)},
+      event{std::make_shared<EventFd>()} {
+    if (epoll_fd < 0 || timer_fd < 0)
+        LOG_F(FATAL, "Could not create the reactor: {}", strerror(errno));
+
+    // The data of each event is the file descriptor, to tell them apart
+    for (const auto fd : {event->get_fd(), timer_fd}) {
+        epoll_event ev{.events = EPOLLIN, .data = {.fd = fd}};
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+Reactor::~Reactor() {
+    close(timer_fd);
+    close(epoll_fd);
+}
+
+void Reactor::watch_input(int fd) {
+    if (input_fd >= 0) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, input_fd, nullptr);
+
+    input_fd = fd;
+    if (input_fd < 0) return;
+
+    epoll_event ev{.events = EPOLLIN, .data = {.fd = input_fd}};
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, input_fd, &ev) < 0)
+        LOG_F(ERROR, "Could not watch fd {}: {}", input_fd, strerror(errno));
+}
+
+void Reactor::set_timer(std::chrono::microseconds period) {
+    using namespace std::chrono;
+
+    const auto secs = duration_cast<seconds>(period);
+    const timespec ts{
+        .tv_sec = static_cast<time_t>(secs.count()),
+        .tv_nsec = static_cast<long>(
+            duration_cast<nanoseconds>(period - secs).count())};
+
+    // The first expiration is one period from now, then every period
+    const itimerspec spec{.it_interval = ts, .it_value = ts};
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+}
+
+Reactor::Wakeup Reactor::wait(std::chrono::milliseconds timeout) {
+    array<epoll_event, 3> events;
+    Wakeup w;
+
+    const auto n = epoll_wait(epoll_fd, events.data(), events.size(),
+                              static_cast<int>(timeout.count()));
+    if (n < 0) {
+        // Signal handlers always interrupt `epoll_wait`, even with
+        // `SA_RESTART`, which is how we get to know about them
+        w.interrupted = errno == EINTR;
+        return w;
+    }
+
+    for (int i{}; i < n; i++) {
+        const auto fd = events[i].data.fd;
+
+        if (fd == event->get_fd()) {
+            event->drain();
+            w.woken = true;
+        } else if (fd == timer_fd) {
+            u64 expirations;
+            [[maybe_unused]] const auto r =
+                ::read(timer_fd, &expirations, sizeof(expirations));
+            w.timer = true;
+        } else if (fd == input_fd) {
+            w.input = true;
+        }
+    }
+
+    return w;
+}
+} // namespace uppr::os
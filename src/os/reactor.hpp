@@ -0,0 +1,131 @@
+#pragma once
+
+#include "commom.hpp"
+
+#include <chrono>
+#include <memory>
+
+namespace uppr::os {
+
+/**
+ * An `eventfd`, closed when destroyed.
+ */
+class EventFd {
+public:
+    EventFd();
+    ~EventFd();
+
+    EventFd(const EventFd &) = delete;
+    EventFd &operator=(const EventFd &) = delete;
+
+    /**
+     * Make the file descriptor readable. Safe to call from any thread and
+     * from signal handlers.
+     */
+    void signal() const noexcept;
+
+    /**
+     * Make it not readable again.
+     */
+    void drain() const noexcept;
+
+    int get_fd() const noexcept { return fd; }
+
+private:
+    int fd;
+};
+
+/**
+ * Wakes up a `Reactor` that is waiting, from any thread.
+ *
+ * This is cheap to copy, and stays safe to use after the reactor is gone
+ * (waking it does nothing then).
+ */
+class Waker {
+public:
+    Waker() = default;
+    explicit Waker(std::shared_ptr<const EventFd> e) : event{std::move(e)} {}
+
+    void wake() const noexcept {
+        if (event) event->signal();
+    }
+
+private:
+    std::shared_ptr<const EventFd> event;
+};
+
+/**
+ * Block until something happens, instead of polling.
+ *
+ * The things that can happen are: input on a file descriptor, another thread
+ * calling `Waker::wake()`, a periodic timer firing (see `set_timer()`) or a
+ * signal being handled.
+ */
+class Reactor {
+public:
+    /**
+     * What woke up a call to `wait()`.
+     */
+    struct Wakeup {
+        /**
+         * The input file descriptor is readable.
+         */
+        bool input{};
+
+        /**
+         * Someone called `Waker::wake()`.
+         */
+        bool woken{};
+
+        /**
+         * The timer fired (maybe more than once).
+         */
+        bool timer{};
+
+        /**
+         * A signal handler ran (like the one for `SIGWINCH`).
+         */
+        bool interrupted{};
+
+        bool any() const noexcept {
+            return input || woken || timer || interrupted;
+        }
+    };
+
+public:
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /**
+     * Wake up when `fd` is readable. Only one input is watched at a time, and
+     * a negative `fd` watches nothing.
+     */
+    void watch_input(int fd);
+
+    /**
+     * Get something that other threads can use to wake us up.
+     */
+    Waker get_waker() const { return Waker{event}; }
+
+    /**
+     * Fire the timer every `period`, or stop it if zero.
+     */
+    void set_timer(std::chrono::microseconds period);
+
+    /**
+     * Wait until something happens, or until `timeout` runs out (forever if
+     * negative). An empty `Wakeup` means that it timed out.
+     */
+    Wakeup wait(std::chrono::milliseconds timeout);
+
+private:
+    int epoll_fd;
+    int timer_fd;
+    int input_fd{-1};
+
+    std::shared_ptr<EventFd> event;
+};
+} // namespace uppr::os
@@ -38,6 +38,12 @@ public:
         return q.empty();
     }
 
+    // Get how many elements are waiting.
+    size_t size() {
+        std::unique_lock<std::mutex> lock(m);
+        return q.size();
+    }
+
 private:
     std::queue<T> q;
     mutable std::mutex m;
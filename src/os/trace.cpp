@@ -0,0 +1,235 @@
+#include "trace.hpp"
+#include "fmt/format.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unistd.h>
+#include <vector>
+
+namespace uppr::trace {
+
+namespace {
+
+struct Event {
+    const char *name{};
+    const char *category{};
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+/**
+ * The ring of a thread, and what is shown as its track.
+ */
+struct Track {
+    /**
+     * Only the thread that owns it records, but it can be written out from
+     * any thread.
+     */
+    std::mutex mutex;
+
+    std::vector<Event> events;
+
+    /**
+     * How many events were recorded, the last one is at `(head - 1) %
+     * ring_size`.
+     */
+    usize head{};
+
+    usize id{};
+    std::string name;
+
+    /**
+     * If a thread is recording into it.
+     */
+    bool in_use{};
+};
+
+struct Registry {
+    std::mutex mutex;
+
+    std::vector<std::unique_ptr<Track>> tracks;
+
+    std::set<std::string, std::less<>> strings;
+
+    std::string filename;
+
+    /**
+     * Time zero of the trace.
+     */
+    Clock::time_point epoch;
+};
+
+Registry &registry() {
+    static Registry r;
+    return r;
+}
+
+/**
+ * Gives the track back when the thread ends.
+ */
+struct Owner {
+    Track *track{};
+
+    ~Owner() {
+        if (!track) return;
+
+        const std::lock_guard lock{registry().mutex};
+        track->in_use = false;
+    }
+};
+
+thread_local Owner owner;
+
+Track &this_track() {
+    if (owner.track) return *owner.track;
+
+    auto &r = registry();
+    const std::lock_guard lock{r.mutex};
+
+    for (const auto &t : r.tracks) {
+        if (!t->in_use) {
+            owner.track = t.get();
+            break;
+        }
+    }
+
+    if (!owner.track) {
+        auto t = std::make_unique<Track>();
+        t->id = r.tracks.size() + 1;
+        t->name = fmt::format("thread {}", t->id);
+        t->events.resize(ring_size);
+
+        owner.track = r.tracks.emplace_back(std::move(t)).get();
+    }
+
+    owner.track->in_use = true;
+    return *owner.track;
+}
+
+void write_escaped(std::FILE *file, string_view s) {
+    for (const auto c : s) {
+        switch (c) {
+        case '"': std::fputs("\\\"", file); break;
+        case '\\': std::fputs("\\\\", file); break;
+        case '\n': std::fputs("\\n", file); break;
+        case '\t': std::fputs("\\t", file); break;
+        default:
+            if (static_cast<uchar>(c) < 0x20)
+                fmt::print(file, "\\u{:04x}", static_cast<int>(c));
+            else
+                std::fputc(c, file);
+        }
+    }
+}
+
+double to_us(Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+} // namespace
+
+void record(const char *name, const char *category, Clock::time_point start,
+            Clock::time_point end) {
+    if (!enabled()) return;
+
+    auto &t = this_track();
+    const std::lock_guard lock{t.mutex};
+    t.events[t.head++ % ring_size] = {name, category, start, end};
+}
+
+const char *intern(string_view s) {
+    auto &r = registry();
+    const std::lock_guard lock{r.mutex};
+
+    auto it = r.strings.find(s);
+    if (it == r.strings.end()) it = r.strings.emplace(s).first;
+
+    return it->c_str();
+}
+
+void set_thread_name(const char *name) {
+    if (!enabled()) return;
+
+    auto &t = this_track();
+    const std::lock_guard lock{t.mutex};
+    t.name = name;
+}
+
+void flush() {
+    auto &r = registry();
+    const std::lock_guard lock{r.mutex};
+    if (r.filename.empty()) return;
+
+    const auto file = std::fopen(r.filename.c_str(), "w");
+    if (!file) {
+        LOG_F(ERROR, "Could not open {}: {}", r.filename, strerror(errno));
+        return;
+    }
+
+    const auto pid = getpid();
+    usize count{};
+
+    std::fputs("{\"traceEvents\":[\n", file);
+    auto first = true;
+    const auto separate = [&] {
+        if (!first) std::fputs(",\n", file);
+        first = false;
+    };
+
+    for (const auto &t : r.tracks) {
+        const std::lock_guard track_lock{t->mutex};
+
+        separate();
+        fmt::print(file,
+                   "{{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":{},"
+                   "\"tid\":{},\"args\":{{\"name\":\"",
+                   pid, t->id);
+        write_escaped(file, t->name);
+        std::fputs("\"}}", file);
+
+        // Oldest first, the ring may have wrapped around
+        const auto n = std::min(t->head, ring_size);
+        for (auto i = t->head - n; i < t->head; i++) {
+            const auto &e = t->events[i % ring_size];
+
+            separate();
+            std::fputs("{\"ph\":\"X\",\"name\":\"", file);
+            write_escaped(file, e.name);
+            fmt::print(file,
+                       "\",\"cat\":\"{}\",\"pid\":{},\"tid\":{},"
+                       "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                       e.category, pid, t->id, to_us(e.start - r.epoch),
+                       to_us(e.end - e.start));
+        }
+
+        count += n;
+    }
+
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+
+    LOG_F(INFO, "Wrote {} spans to {}", count, r.filename);
+}
+
+Session::Session(std::string filename) {
+    {
+        auto &r = registry();
+        const std::lock_guard lock{r.mutex};
+        r.filename = std::move(filename);
+        r.epoch = Clock::now();
+    }
+
+    detail::recording = true;
+}
+
+Session::~Session() {
+    detail::recording = false;
+    flush();
+
+    const std::lock_guard lock{registry().mutex};
+    registry().filename.clear();
+}
+} // namespace uppr::trace
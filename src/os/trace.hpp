@@ -0,0 +1,102 @@
+/**
+ * @file Records spans of time on each thread, to be looked at as a timeline
+ * in `chrome://tracing` or https://ui.perfetto.dev.
+ *
+ * Nothing is recorded unless there is a `Session`. Each thread records into a
+ * ring of its own, which keeps the last `ring_size` spans, and shows up as a
+ * track of its own. Threads that end give their ring to the next thread that
+ * starts, so short lived threads (like the ones that send messages) dont use
+ * more memory than the most that ran at the same time.
+ */
+
+#pragma once
+
+#include "commom.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace uppr::trace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * How many spans each thread keeps.
+ */
+constexpr usize ring_size = 64 * 1024;
+
+namespace detail {
+inline std::atomic<bool> recording{};
+} // namespace detail
+
+/**
+ * If spans are being recorded.
+ */
+inline bool enabled() noexcept {
+    return detail::recording.load(std::memory_order_relaxed);
+}
+
+/**
+ * Record a span that went from `start` until `end` on the calling thread.
+ *
+ * The strings are not copied, so they must be string literals or come from
+ * `intern()`.
+ */
+void record(const char *name, const char *category, Clock::time_point start,
+            Clock::time_point end);
+
+/**
+ * Get a copy of `s` that lives until the program ends. The same string always
+ * gives the same copy.
+ */
+const char *intern(string_view s);
+
+/**
+ * Name the track of the calling thread.
+ */
+void set_thread_name(const char *name);
+
+/**
+ * Write everything that the rings have to the file of the session, if there
+ * is one.
+ */
+void flush();
+
+/**
+ * Records a span from its construction to its destruction.
+ */
+class Span {
+public:
+    Span(const char *name, const char *category)
+        : name{name}, category{category} {
+        if (enabled()) start = Clock::now();
+    }
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+    ~Span() {
+        if (start != Clock::time_point{})
+            record(name, category, start, Clock::now());
+    }
+
+private:
+    const char *name;
+    const char *category;
+    Clock::time_point start{};
+};
+
+/**
+ * Records spans while it exists, writing them to `filename` as Chrome trace
+ * event JSON when destroyed (and on every `flush()`).
+ */
+class Session {
+public:
+    explicit Session(std::string filename);
+    ~Session();
+
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+};
+} // namespace uppr::trace
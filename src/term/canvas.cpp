@@ -0,0 +1,84 @@
+#include "canvas.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace uppr::term {
+
+namespace {
+
+/**
+ * Where `Canvas::vprint` formats text. It only grows, so once it fits the
+ * longest line printed, printing never allocates.
+ */
+thread_local fmt::memory_buffer scratch;
+} // namespace
+
+void Canvas::fill(Rect rect, const Pixel &pixel) {
+    const auto r = Rect{origin + rect.tl, rect.size}.intersect(clip);
+
+    for (auto y = r.top(); y < r.bottom(); y++)
+        std::fill_n(at(r.left(), y), r.size.getx(), pixel);
+}
+
+int Canvas::glyphs(int x, int y, string_view text, PackedStyle style) {
+    const auto start = x;
+    x += origin.getx();
+    y += origin.gety();
+
+    // Glyphs before the clipping rectangle are decoded and thrown away, the
+    // visible ones are written, and the ones after it are only counted
+    if (y >= clip.top() && y < clip.bottom()) {
+        while (!text.empty() && x < clip.left()) {
+            text.remove_prefix(decode_utf8(text).second);
+            x++;
+        }
+
+        if (x < clip.right()) {
+            auto dst = at(x, y);
+            const auto end = at(clip.right(), y);
+
+            while (!text.empty() && dst < end) {
+                const auto [c, n] = decode_utf8(text);
+                text.remove_prefix(n);
+
+                *dst++ = Pixel{c, style};
+                x++;
+            }
+        }
+    }
+
+    // Every byte that is not a continuation starts a glyph
+    x += std::count_if(text.begin(), text.end(), [](char c) {
+        return (static_cast<uchar>(c) & 0xC0) != 0x80;
+    });
+
+    return x - origin.getx() - start;
+}
+
+void Canvas::copy_row(int x, int y, span<const Pixel> row) {
+    const auto r =
+        Rect{origin + Transform{x, y}, {row.size(), 1}}.intersect(clip);
+    if (r.empty()) return;
+
+    const auto src = &row[r.left() - (origin.getx() + x)];
+    const auto dst = at(r.left(), r.top());
+
+    for (usize i{}; i < r.size.getx(); i++) {
+        if (!src[i].is_transparent()) dst[i] = src[i];
+    }
+}
+
+int Canvas::vprint(int x, int y, fmt::text_style style, fmt::string_view fmt,
+                   fmt::format_args args) {
+    // Lines that are not visible are not even formatted
+    if (y + origin.gety() < clip.top() || y + origin.gety() >= clip.bottom())
+        return 0;
+
+    scratch.clear();
+    fmt::vformat_to(std::back_inserter(scratch), fmt, args);
+
+    return glyphs(x, y, {scratch.data(), scratch.size()}, PackedStyle{style});
+}
+} // namespace uppr::term
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "commom.hpp"
+#include "fmt/color.h"
+#include "fmt/core.h"
+#include "pixel.hpp"
+#include "rect.hpp"
+#include "style.hpp"
+#include "vector2.hpp"
+
+namespace uppr::term {
+
+/**
+ * A view into what a `TermScreen` is drawing to (the buffer or a layer), with
+ * its own origin and clipping rectangle.
+ *
+ * Coordinates given to a canvas are relative to its origin, and anything
+ * outside of its clipping rectangle is discarded. Clipping is done once for
+ * each span of cells, so filling or printing a whole line is just a bounds
+ * check and a copy.
+ *
+ * Get one with `TermScreen::canvas()`. It is only valid until the screen
+ * changes what it draws to (`clear()`, `push_layer()` or `pop_layer()`).
+ */
+class Canvas {
+public:
+    /**
+     * A canvas that discards everything.
+     */
+    Canvas() = default;
+
+    /**
+     * View `pixels` (which covers `target` in screen coordinates) from
+     * `origin`, only drawing inside of `clip`.
+     */
+    Canvas(Pixel *pixels, Rect target, Transform origin, Size size, Rect clip)
+        : pixels{pixels}, target{target}, origin{origin}, size{size},
+          clip{clip.intersect(target)} {}
+
+public:
+    /**
+     * Get where the origin of the canvas is, in screen coordinates.
+     */
+    constexpr Transform get_origin() const noexcept { return origin; }
+
+    /**
+     * Get the size that the canvas was created with. Parts of it may be
+     * clipped.
+     */
+    constexpr Size get_size() const noexcept { return size; }
+
+    /**
+     * Get the part of the screen that can be drawn to.
+     */
+    constexpr Rect get_clip() const noexcept { return clip; }
+
+    /**
+     * Get a smaller canvas at `tl` (relative to this one), clipped to both.
+     */
+    Canvas view(Transform tl, Size s) const {
+        const Rect r{origin + tl, s};
+        return {pixels, target, r.tl, s, clip.intersect(r)};
+    }
+
+public:
+    /**
+     * Set a single pixel.
+     */
+    void setc(int x, int y, const Pixel &pixel) {
+        fill({{x, y}, {1, 1}}, pixel);
+    }
+
+    /**
+     * Set every pixel inside of `rect`.
+     */
+    void fill(Rect rect, const Pixel &pixel);
+
+    /**
+     * Draw a horizontal line from `sx` up to `ex` (exclusive).
+     */
+    void hline(int sx, int ex, int y, const Pixel &pixel) {
+        if (ex > sx) fill({{sx, y}, {static_cast<usize>(ex - sx), 1}}, pixel);
+    }
+
+    /**
+     * Draw a vertical line from `sy` up to `ey` (exclusive).
+     */
+    void vline(int x, int sy, int ey, const Pixel &pixel) {
+        if (ey > sy) fill({{x, sy}, {1, static_cast<usize>(ey - sy)}}, pixel);
+    }
+
+    /**
+     * Write the UTF-8 `text` on a single line with a single style, stopping
+     * at the edge of the clipping rectangle.
+     *
+     * @return How many columns the whole text takes, clipped or not.
+     */
+    int glyphs(int x, int y, string_view text, PackedStyle style);
+
+    /**
+     * Copy a row of pixels to a single line. Transparent pixels are skipped,
+     * so that whatever is below them stays.
+     */
+    void copy_row(int x, int y, span<const Pixel> row);
+
+    /**
+     * Print the formatted string on a single line. The format string is
+     * checked at compile time, and formatting does not allocate.
+     *
+     * **WARNING**: Styling should not be used in the arguments here!
+     *
+     * @return How many columns the whole text takes, clipped or not, or 0 if
+     * the line is outside of the clipping rectangle.
+     */
+    template <typename... Args>
+    int print(int x, int y, fmt::text_style style,
+              fmt::format_string<Args...> fmt, Args &&...args) {
+        return vprint(x, y, style, fmt, fmt::make_format_args(args...));
+    }
+
+    /**
+     * Print the formatted string on a single line with the default style.
+     *
+     * **WARNING**: Styling should not be used in the arguments here!
+     *
+     * @return How many columns the whole text takes, clipped or not, or 0 if
+     * the line is outside of the clipping rectangle.
+     */
+    template <typename... Args>
+    int print(int x, int y, fmt::format_string<Args...> fmt, Args &&...args) {
+        return vprint(x, y, {}, fmt, fmt::make_format_args(args...));
+    }
+
+    /**
+     * Format into a scratch buffer owned by the thread, and then write it as
+     * glyphs. The buffer is reused, so this only allocates when a line
+     * longer than any before it is printed.
+     */
+    int vprint(int x, int y, fmt::text_style style, fmt::string_view fmt,
+               fmt::format_args args);
+
+private:
+    /**
+     * Get the pixel at the given screen coordinates, which must be inside of
+     * `target`.
+     */
+    Pixel *at(int x, int y) const {
+        return &pixels[(y - target.top()) * target.size.getx() +
+                       (x - target.left())];
+    }
+
+private:
+    Pixel *pixels{};
+    Rect target;
+    Transform origin;
+    Size size;
+    Rect clip;
+};
+} // namespace uppr::term
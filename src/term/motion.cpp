@@ -0,0 +1,180 @@
+#include "motion.hpp"
+#include "utf8.hpp"
+
+#include <charconv>
+
+namespace uppr::term {
+
+namespace {
+
+/**
+ * Small helper to append things to a `Motion`.
+ */
+class MotionWriter {
+public:
+    explicit MotionWriter(Motion &m) : motion{m} {}
+
+    void put(string_view s) {
+        for (const auto c : s)
+            motion.bytes[motion.size++] = c;
+    }
+
+    void put(char c, usize count = 1) {
+        for (usize i{}; i < count; i++)
+            motion.bytes[motion.size++] = c;
+    }
+
+    void number(usize n) {
+        const auto begin = motion.bytes.data() + motion.size;
+        const auto end = motion.bytes.data() + motion.bytes.size();
+        motion.size += std::to_chars(begin, end, n).ptr - begin;
+    }
+
+    /**
+     * A control sequence with a single count parameter, omitted when 1.
+     */
+    void csi(usize n, char final) {
+        put("\x1B["sv);
+        if (n != 1) number(n);
+        put(final);
+    }
+
+    usize room() const { return motion.bytes.size() - motion.size; }
+
+private:
+    Motion &motion;
+};
+
+/**
+ * Size of `CSI n <final>`, with n omitted when 1.
+ */
+constexpr usize csi_size(usize n) {
+    if (n == 1) return 3;
+
+    usize digits = 1;
+    for (; n >= 10; n /= 10)
+        digits++;
+
+    return 3 + digits;
+}
+
+/**
+ * Size of printing again the glyphs of `row` in `[from, to)`, or empty if not
+ * possible (different styles, or too long to be worth it).
+ */
+optional<usize> rewrite_size(span<const Pixel> row, usize from, usize to,
+                             PackedStyle style, usize limit) {
+    if (to > row.size()) return std::nullopt;
+
+    usize size{};
+    char encoded[4];
+    for (usize i{from}; i < to; i++) {
+        if (row[i].get_packed_style() != style) return std::nullopt;
+
+        size += encode_utf8(row[i].get_glyph(), encoded);
+        if (size >= limit) return std::nullopt;
+    }
+
+    return size;
+}
+
+/**
+ * Write the glyphs of `row` in `[from, to)`.
+ */
+void rewrite(MotionWriter &w, span<const Pixel> row, usize from, usize to) {
+    char encoded[4];
+    for (usize i{from}; i < to; i++)
+        w.put({encoded, encode_utf8(row[i].get_glyph(), encoded)});
+}
+
+/**
+ * Plan the horizontal part of the motion, when already on the right line.
+ */
+void plan_horizontal(MotionWriter &w, usize from, usize to,
+                     span<const Pixel> row, PackedStyle style) {
+    if (from == to) return;
+
+    if (to > from) {
+        // Forward: either CUF or printing what is already there
+        const auto cuf = csi_size(to - from);
+        const auto re = rewrite_size(row, from, to, style, cuf);
+
+        if (re && *re < cuf)
+            rewrite(w, row, from, to);
+        else
+            w.csi(to - from, 'C');
+
+        return;
+    }
+
+    // Backwards: CUB, backspaces or a carriage return and then forward
+    const auto back = from - to;
+    const auto cub = csi_size(back);
+
+    optional<usize> after_cr;
+    if (to == 0) {
+        after_cr = 0;
+    } else {
+        const auto cuf = csi_size(to);
+        const auto re = rewrite_size(row, 0, to, style, cuf);
+        after_cr = re ? std::min(*re, cuf) : cuf;
+    }
+
+    const auto cr = 1 + *after_cr;
+
+    if (back <= cub && back <= cr) {
+        w.put('\b', back);
+    } else if (cub <= cr) {
+        w.csi(back, 'D');
+    } else {
+        w.put('\r');
+        plan_horizontal(w, 0, to, row, style);
+    }
+}
+} // namespace
+
+Motion absolute_motion(CursorPos to) {
+    Motion m;
+    MotionWriter w{m};
+
+    // x and y are inverted in the command, and 1 based. Both can be left out
+    // when they are 1.
+    w.put("\x1B["sv);
+    if (to.y != 0 || to.x != 0) w.number(to.y + 1);
+    if (to.x != 0) {
+        w.put(';');
+        w.number(to.x + 1);
+    }
+    w.put('H');
+
+    return m;
+}
+
+Motion plan_motion(optional<CursorPos> from, CursorPos to,
+                   span<const Pixel> row, PackedStyle style) {
+    auto best = absolute_motion(to);
+    if (!from) return best;
+    if (*from == to) return {};
+
+    Motion relative;
+    MotionWriter w{relative};
+
+    // Vertical part first (this keeps the column), with line feeds or
+    // CUD when going down and CUU when going up.
+    if (to.y > from->y) {
+        const auto down = to.y - from->y;
+        if (down <= csi_size(down))
+            w.put('\n', down);
+        else
+            w.csi(down, 'B');
+    } else if (to.y < from->y) {
+        w.csi(from->y - to.y, 'A');
+    }
+
+    // Only bother with the horizontal part if it can still win
+    if (relative.size >= best.size) return best;
+    plan_horizontal(w, from->x, to.x, row, style);
+
+    return relative.size < best.size ? relative : best;
+}
+} // namespace uppr::term
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "commom.hpp"
+#include "pixel.hpp"
+#include "style.hpp"
+
+namespace uppr::term {
+
+/**
+ * A cursor position in the screen (0 based).
+ */
+struct CursorPos {
+    usize x{};
+    usize y{};
+
+    constexpr bool operator==(const CursorPos &) const = default;
+};
+
+/**
+ * The bytes that move the cursor somewhere.
+ */
+struct Motion {
+    /**
+     * Big enough for any escape sequence, and for rewriting a few glyphs
+     * (which is only done when it is shorter than the escape sequences).
+     */
+    static constexpr usize max_size = 64;
+
+    array<char, max_size> bytes;
+    usize size{};
+
+    constexpr string_view view() const { return {bytes.data(), size}; }
+};
+
+/**
+ * Plan the cheapest way (in bytes) of moving the cursor from `from` to `to`.
+ *
+ * The options considered are:
+ * - absolute positioning (`CUP`), in its shortest form
+ * - relative moves (`CUU`/`CUD`/`CUF`/`CUB`)
+ * - carriage returns, line feeds and backspaces
+ * - just printing again the glyphs that are already on the screen between the
+ *   cursor and the target, when they all use the current `style`
+ *
+ * @param from Where the cursor is, or empty if that is unknown (in which case
+ * only absolute positioning is possible).
+ * @param to Where the cursor should go.
+ * @param row What the terminal is showing in the line of `to`, used for
+ * rewriting glyphs.
+ * @param style The style that the terminal is currently using.
+ */
+Motion plan_motion(optional<CursorPos> from, CursorPos to,
+                   span<const Pixel> row, PackedStyle style);
+
+/**
+ * Get the absolute positioning sequence (`CUP`) to `to`, in its shortest form.
+ */
+Motion absolute_motion(CursorPos to);
+} // namespace uppr::term
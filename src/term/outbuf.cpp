@@ -0,0 +1,46 @@
+#include "outbuf.hpp"
+#include "loguru.hpp"
+
+#include <cerrno>
+#include <unistd.h>
+
+namespace uppr::term {
+
+void OutputBuffer::flush() {
+    if (buffer.empty()) return;
+
+    usize written{};
+    usize syscalls{};
+
+    if (sink) {
+        sink(buffer);
+        written = buffer.size();
+        syscalls = 1;
+    }
+
+    // `write` may not take everything at once (specially with a slow pty on
+    // the other side), so keep going until all of it is out.
+    while (written < buffer.size()) {
+        const auto n =
+            ::write(fd, buffer.data() + written, buffer.size() - written);
+        syscalls++;
+
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+
+            LOG_F(ERROR, "Error writing to the terminal: {}", errno);
+            break;
+        }
+
+        written += static_cast<usize>(n);
+    }
+
+    stats.flushes++;
+    stats.syscalls += syscalls;
+    stats.bytes += written;
+    stats.last_syscalls = syscalls;
+    stats.last_bytes = written;
+
+    buffer.clear();
+}
+} // namespace uppr::term
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "commom.hpp"
+#include "fmt/color.h"
+#include "fmt/core.h"
+
+#include <functional>
+#include <iterator>
+#include <string>
+
+namespace uppr::term {
+
+/**
+ * Counters of what was sent to the terminal.
+ */
+struct OutputStats {
+    /**
+     * How many times the buffer was flushed with something in it.
+     */
+    usize flushes{};
+
+    /**
+     * Total number of `write` syscalls made.
+     */
+    usize syscalls{};
+
+    /**
+     * Total number of bytes written.
+     */
+    usize bytes{};
+
+    /**
+     * Number of `write` syscalls made by the last flush.
+     */
+    usize last_syscalls{};
+
+    /**
+     * Number of bytes written by the last flush.
+     */
+    usize last_bytes{};
+};
+
+/**
+ * Something that takes the output in place of a file descriptor, like a
+ * `VirtualTerminal`. Each call counts as one `write` syscall in the stats.
+ */
+using OutputSink = std::function<void(string_view)>;
+
+/**
+ * A staging buffer for everything that goes to the terminal.
+ *
+ * Output is appended to a single preallocated buffer, and then sent with as
+ * few `write` calls as possible on `flush()` (normally just one per frame).
+ * This bypasses stdio completelly, so nothing else should write to the same
+ * file descriptor with `FILE` functions.
+ */
+class OutputBuffer {
+public:
+    /**
+     * How many bytes to reserve up front. This is enough for a full repaint of
+     * a big terminal without ever reallocating.
+     */
+    static constexpr usize initial_capacity = 64 * 1024;
+
+    /**
+     * Create the buffer for writing to the given file descriptor.
+     */
+    explicit OutputBuffer(int output_file_descr) : fd{output_file_descr} {
+        buffer.reserve(initial_capacity);
+    }
+
+    /**
+     * Create the buffer for handing everything to the given sink.
+     */
+    explicit OutputBuffer(OutputSink output_sink)
+        : fd{-1}, sink{std::move(output_sink)} {
+        buffer.reserve(initial_capacity);
+    }
+
+public:
+    /**
+     * Append raw bytes.
+     */
+    void append(string_view text) { buffer.append(text); }
+
+    /**
+     * Append a single byte.
+     */
+    void push(char c) { buffer.push_back(c); }
+
+    /**
+     * Append the result of a format string.
+     */
+    void vformat(fmt::string_view fmt, fmt::format_args args) {
+        fmt::vformat_to(std::back_inserter(buffer), fmt, args);
+    }
+
+    /**
+     * Append the result of a format string with the given style.
+     */
+    void vformat(const fmt::text_style &ts, fmt::string_view fmt,
+                 fmt::format_args args) {
+        fmt::vformat_to(std::back_inserter(buffer), ts, fmt, args);
+    }
+
+    /**
+     * Write everything that is buffered to the file descriptor, and empty the
+     * buffer (keeping the allocated memory around for the next frame).
+     */
+    void flush();
+
+    /**
+     * Number of bytes waiting to be flushed.
+     */
+    usize size() const noexcept { return buffer.size(); }
+
+    /**
+     * If nothing is waiting to be flushed.
+     */
+    bool empty() const noexcept { return buffer.empty(); }
+
+    /**
+     * Get the counters of what was written so far.
+     */
+    const OutputStats &get_stats() const noexcept { return stats; }
+
+private:
+    /**
+     * Where to write to.
+     */
+    int fd;
+
+    /**
+     * Where to write to instead of `fd`, if set.
+     */
+    OutputSink sink;
+
+    /**
+     * The staging buffer. This is a `std::string` because fmt can append to
+     * it directly instead of going char by char.
+     */
+    std::string buffer;
+
+    /**
+     * Output counters.
+     */
+    OutputStats stats;
+};
+} // namespace uppr::term
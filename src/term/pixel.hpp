@@ -2,6 +2,9 @@
 
 #include "commom.hpp"
 #include "fmt/color.h"
+#include "style.hpp"
+
+#include <type_traits>
 
 namespace uppr::term {
 
@@ -9,6 +12,10 @@ namespace uppr::term {
  * Represent a 'pixel' in the screen.
  *
  * In our case a pixel is simply a character assossiated with a printing style.
+ *
+ * This is a plain trivially copyable struct with no padding, so buffers of
+ * pixels can be cleared with `memset` and compared with `memcmp`. An all zero
+ * pixel is a space with the default style.
  */
 class Pixel {
 public:
@@ -16,45 +23,115 @@ public:
      * Constructs a space with default styles.
      */
     constexpr Pixel() = default;
-    
+
     /**
      * Constructs with the given character and default styles.
      */
-    constexpr Pixel(char c) : ch{c} {}
+    constexpr Pixel(char c) : glyph{pack_glyph(static_cast<uchar>(c))} {}
 
     /**
      * Constructs with the given character and styles.
      */
-    constexpr Pixel(char c, const fmt::text_style &s) : ch{c}, style{s} {}
+    constexpr Pixel(char c, const fmt::text_style &s)
+        : glyph{pack_glyph(static_cast<uchar>(c))}, style{s} {}
+
+    /**
+     * Constructs with the given unicode code point and packed style.
+     */
+    constexpr Pixel(char32_t c, PackedStyle s) : glyph{pack_glyph(c)}, style{s} {}
 
 public:
     /**
      * Get the character stored inside.
+     *
+     * For characters outside of ASCII, use `get_glyph()`.
+     */
+    constexpr char getc() const noexcept {
+        return static_cast<char>(get_glyph());
+    }
+
+    /**
+     * Get the unicode code point stored inside.
      */
-    constexpr char getc() const noexcept { return ch; }
+    constexpr char32_t get_glyph() const noexcept {
+        return glyph ? glyph : U' ';
+    }
 
     /**
      * Get the text style stored inside.
      */
-    constexpr fmt::text_style get_style() const noexcept { return style; }
+    constexpr fmt::text_style get_style() const noexcept {
+        return style.to_text_style();
+    }
+
+    /**
+     * Get the packed text style stored inside.
+     */
+    constexpr PackedStyle get_packed_style() const noexcept { return style; }
 
     /**
      * Set the text style stored inside.
      */
-    constexpr void set_style(const fmt::text_style& s) noexcept { style = s; }
+    constexpr void set_style(const fmt::text_style &s) noexcept { style = s; }
+
+    /**
+     * Set the text style stored inside.
+     */
+    constexpr void set_style(PackedStyle s) noexcept { style = s; }
+
+    /**
+     * Constructs a pixel that is not drawn when copied from a `Surface`.
+     */
+    static constexpr Pixel transparent() noexcept {
+        Pixel p;
+        p.flags = transparent_flag;
+
+        return p;
+    }
+
+    /**
+     * If this pixel is a placeholder that should not be drawn.
+     */
+    constexpr bool is_transparent() const noexcept {
+        return flags & transparent_flag;
+    }
 
     // Compare objects
-    constexpr bool operator==(const Pixel&) const = default;
+    constexpr bool operator==(const Pixel &) const = default;
+
+public:
+    /**
+     * Marks a pixel that was never drawn to in a `Surface`.
+     */
+    static constexpr u32 transparent_flag = 1;
 
 private:
     /**
-     * The character stored in the pixel.
+     * Spaces are stored as zero, so that a blank pixel is all zeroes.
      */
-    char ch{' '};
+    static constexpr u32 pack_glyph(char32_t c) noexcept {
+        return c == U' ' ? 0 : c;
+    }
+
+private:
+    /**
+     * The unicode code point stored in the pixel (zero for a space).
+     */
+    u32 glyph{};
+
+    /**
+     * Extra flags, like `transparent_flag`. Always zero for pixels in the
+     * screen buffer.
+     */
+    u32 flags{};
 
     /**
      * The formatting style of the character.
      */
-    fmt::text_style style;
+    PackedStyle style;
 };
+
+static_assert(std::is_trivially_copyable_v<Pixel>);
+static_assert(std::has_unique_object_representations_v<Pixel>);
+static_assert(sizeof(Pixel) == 16);
 } // namespace uppr::term
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "commom.hpp"
+#include "vector2.hpp"
+
+#include <algorithm>
+
+namespace uppr::term {
+
+/**
+ * A rectangle in screen coordinates, given by its top left corner and size.
+ */
+struct Rect {
+    /**
+     * Left edge (inclusive).
+     */
+    constexpr int left() const noexcept { return tl.getx(); }
+
+    /**
+     * Top edge (inclusive).
+     */
+    constexpr int top() const noexcept { return tl.gety(); }
+
+    /**
+     * Right edge (exclusive).
+     */
+    constexpr int right() const noexcept {
+        return tl.getx() + static_cast<int>(size.getx());
+    }
+
+    /**
+     * Bottom edge (exclusive).
+     */
+    constexpr int bottom() const noexcept {
+        return tl.gety() + static_cast<int>(size.gety());
+    }
+
+    /**
+     * If the rectangle has no cells at all.
+     */
+    constexpr bool empty() const noexcept {
+        return size.getx() == 0 || size.gety() == 0;
+    }
+
+    /**
+     * Get the part of this rectangle that is also inside of `o`.
+     */
+    constexpr Rect intersect(const Rect &o) const noexcept {
+        const auto l = std::max(left(), o.left());
+        const auto t = std::max(top(), o.top());
+        const auto r = std::min(right(), o.right());
+        const auto b = std::min(bottom(), o.bottom());
+
+        if (r <= l || b <= t) return {};
+
+        return {{l, t}, {static_cast<usize>(r - l), static_cast<usize>(b - t)}};
+    }
+
+    constexpr bool operator==(const Rect &) const = default;
+
+    Transform tl{};
+    Size size{};
+};
+} // namespace uppr::term
@@ -0,0 +1,170 @@
+#include "row-diff.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace uppr::term {
+
+namespace {
+
+/**
+ * Turn the first and last changed columns into a span (or a clean one, if
+ * nothing was found).
+ */
+constexpr DirtySpan make_span(usize first, usize last, usize n) {
+    if (first == n) return {};
+
+    return {first, last, true};
+}
+
+} // namespace
+
+DirtySpan diff_row_scalar(const Pixel *a, const Pixel *b, usize n) {
+    usize first{};
+    while (first < n && a[first] == b[first])
+        first++;
+
+    if (first == n) return {};
+
+    usize last = n - 1;
+    while (last > first && a[last] == b[last])
+        last--;
+
+    return make_span(first, last, n);
+}
+
+#if defined(__x86_64__)
+
+namespace {
+
+/**
+ * If the pixel at `a` is different from `b`, comparing all 16 bytes at once.
+ */
+inline bool sse2_differs(const Pixel *a, const Pixel *b) {
+    const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+    const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF;
+}
+
+/**
+ * If any of the 4 pixels starting at `a` is different from `b`.
+ */
+inline bool sse2_differs4(const Pixel *a, const Pixel *b) {
+    const auto pa = reinterpret_cast<const __m128i *>(a);
+    const auto pb = reinterpret_cast<const __m128i *>(b);
+
+    const auto eq0 = _mm_cmpeq_epi8(_mm_loadu_si128(pa + 0),
+                                    _mm_loadu_si128(pb + 0));
+    const auto eq1 = _mm_cmpeq_epi8(_mm_loadu_si128(pa + 1),
+                                    _mm_loadu_si128(pb + 1));
+    const auto eq2 = _mm_cmpeq_epi8(_mm_loadu_si128(pa + 2),
+                                    _mm_loadu_si128(pb + 2));
+    const auto eq3 = _mm_cmpeq_epi8(_mm_loadu_si128(pa + 3),
+                                    _mm_loadu_si128(pb + 3));
+
+    const auto eq = _mm_and_si128(_mm_and_si128(eq0, eq1),
+                                  _mm_and_si128(eq2, eq3));
+
+    return _mm_movemask_epi8(eq) != 0xFFFF;
+}
+
+__attribute__((target("avx2"))) inline bool
+avx2_differs8(const Pixel *a, const Pixel *b) {
+    const auto pa = reinterpret_cast<const __m256i *>(a);
+    const auto pb = reinterpret_cast<const __m256i *>(b);
+
+    const auto eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 0),
+                                       _mm256_loadu_si256(pb + 0));
+    const auto eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 1),
+                                       _mm256_loadu_si256(pb + 1));
+    const auto eq2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 2),
+                                       _mm256_loadu_si256(pb + 2));
+    const auto eq3 = _mm256_cmpeq_epi8(_mm256_loadu_si256(pa + 3),
+                                       _mm256_loadu_si256(pb + 3));
+
+    const auto eq = _mm256_and_si256(_mm256_and_si256(eq0, eq1),
+                                     _mm256_and_si256(eq2, eq3));
+
+    return _mm256_movemask_epi8(eq) != -1;
+}
+
+} // namespace
+
+DirtySpan diff_row_sse2(const Pixel *a, const Pixel *b, usize n) {
+    // Find the first difference, 4 pixels at a time, and then narrow it down
+    usize first{};
+    while (first + 4 <= n && !sse2_differs4(a + first, b + first))
+        first += 4;
+    while (first < n && !sse2_differs(a + first, b + first))
+        first++;
+
+    if (first == n) return {};
+
+    // And the same thing backwards for the last one
+    usize end = n;
+    while (end >= first + 4 && !sse2_differs4(a + end - 4, b + end - 4))
+        end -= 4;
+    while (end > first + 1 && !sse2_differs(a + end - 1, b + end - 1))
+        end--;
+
+    return make_span(first, end - 1, n);
+}
+
+__attribute__((target("avx2"))) DirtySpan
+diff_row_avx2(const Pixel *a, const Pixel *b, usize n) {
+    // Find the first difference, 8 pixels at a time, and then narrow it down
+    usize first{};
+    while (first + 8 <= n && !avx2_differs8(a + first, b + first))
+        first += 8;
+    while (first < n && !sse2_differs(a + first, b + first))
+        first++;
+
+    if (first == n) return {};
+
+    // And the same thing backwards for the last one
+    usize end = n;
+    while (end >= first + 8 && !avx2_differs8(a + end - 8, b + end - 8))
+        end -= 8;
+    while (end > first + 1 && !sse2_differs(a + end - 1, b + end - 1))
+        end--;
+
+    return make_span(first, end - 1, n);
+}
+
+RowDiffFn select_row_diff() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return diff_row_avx2;
+
+    // SSE2 is always there on x86_64
+    return diff_row_sse2;
+}
+
+#else
+
+RowDiffFn select_row_diff() { return diff_row_scalar; }
+
+#endif
+
+DirtySpan diff_row(const Pixel *a, const Pixel *b, usize n) {
+    static const auto selected = select_row_diff();
+
+    return selected(a, b, n);
+}
+
+usize diff_rows(const Pixel *a, const Pixel *b, usize w, usize h,
+                std::vector<DirtySpan> &out) {
+    out.resize(h);
+
+    usize dirty{};
+    for (usize j{}; j < h; j++) {
+        out[j] = diff_row(a + j * w, b + j * w, w);
+        dirty += out[j].dirty;
+    }
+
+    return dirty;
+}
+} // namespace uppr::term
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "commom.hpp"
+#include "pixel.hpp"
+
+#include <vector>
+
+namespace uppr::term {
+
+/**
+ * The range of columns that changed in a single row of the screen.
+ */
+struct DirtySpan {
+    /**
+     * First column that changed.
+     */
+    usize first{};
+
+    /**
+     * Last column that changed (inclusive).
+     */
+    usize last{};
+
+    /**
+     * If anything changed at all. When false, `first` and `last` are
+     * meaningless.
+     */
+    bool dirty{};
+};
+
+/**
+ * Signature of the functions that compare a row of pixels.
+ */
+using RowDiffFn = DirtySpan (*)(const Pixel *a, const Pixel *b, usize n);
+
+/**
+ * Compare a row of `n` pixels one pixel at a time. This is the fallback for
+ * when no vector instructions are available.
+ */
+DirtySpan diff_row_scalar(const Pixel *a, const Pixel *b, usize n);
+
+#if defined(__x86_64__)
+/**
+ * Compare a row of `n` pixels using SSE2 (one pixel per register).
+ */
+DirtySpan diff_row_sse2(const Pixel *a, const Pixel *b, usize n);
+
+/**
+ * Compare a row of `n` pixels using AVX2 (two pixels per register).
+ *
+ * Only call this if the CPU supports AVX2 (see `select_row_diff()`).
+ */
+DirtySpan diff_row_avx2(const Pixel *a, const Pixel *b, usize n);
+#endif
+
+/**
+ * Pick the fastest row comparator that this CPU supports.
+ */
+RowDiffFn select_row_diff();
+
+/**
+ * Compare a row of `n` pixels with the fastest comparator available.
+ */
+DirtySpan diff_row(const Pixel *a, const Pixel *b, usize n);
+
+/**
+ * Compare two `w` by `h` pixel buffers, storing the dirty span of every row
+ * into `out` (which is resized to `h`).
+ *
+ * @return How many rows are dirty.
+ */
+usize diff_rows(const Pixel *a, const Pixel *b, usize w, usize h,
+                std::vector<DirtySpan> &out);
+} // namespace uppr::term
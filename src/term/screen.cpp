@@ -1,64 +1,375 @@
 #include "commom.hpp"
 #include "fmt/color.h"
+#include "metrics.hpp"
+#include "row-diff.hpp"
+#include "trace.hpp"
 #include "screen.hpp"
+#include "utf8.hpp"
 #include <algorithm>
 #include <bits/ranges_algo.h>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 namespace uppr::term {
+
+namespace {
+
+/**
+ * Size of the classic `CSI y;x H` that we would use without the planner.
+ */
+usize full_motion_size(CursorPos to) {
+    return fmt::formatted_size("\x1B[{};{}H", to.y + 1, to.x + 1);
+}
+} // namespace
+
+TermScreen::~TermScreen() {
+    stop_render_thread();
+
+    LOG_F(INFO, "Rendered {} cells over {} frames, {} bytes of cursor motion "
+          "({} saved by the planner), {} scrolled regions, {} cells compared",
+          stats.cells, stats.frames, stats.motion_bytes,
+          stats.motion_bytes_saved, stats.scrolls, stats.compared);
+    LOG_F(INFO, "Dropped {} frames", dropped_frames.load());
+}
+
 void TermScreen::commit() {
+    using namespace std::chrono;
+
     // minor optimization that probably is not needed
     if (!needs_repaint()) return;
     mark_clean();
 
-    // Get the start of the buffer
-    auto ch = buffer.begin();
-    auto start = ch;
+    if (!has_render_thread()) {
+        const auto start = steady_clock::now();
+        {
+            const std::lock_guard lock{output_lock};
 
-    // Get the style of the first pixel
-    fmt::text_style prev_style = ch->get_style();
+            // Try again on the next commit, the buffer should have been
+            // resized by then
+            if (!present(buffer, pending_scrolls, damaged)) mark_dirty();
+        }
 
-    // Convenience function to print all pixels until the given one with
-    // `prev_style`
-    const auto flush_buffered = [&](auto ch) {
-        for (; start != ch; start++)
-            term.print(prev_style, "{}", start->getc());
-    };
+        pending_scrolls.clear();
+        damaged.clear();
+
+        const auto latency = steady_clock::now() - start;
+        metrics::commit_time.record(latency);
+        commit_latency =
+            static_cast<int>(duration_cast<microseconds>(latency).count());
+        return;
+    }
 
-    // Move the cursor to the top-left
-    term.home_cursor();
+    const auto size = buffer.size();
+    {
+        const std::lock_guard lock{frame_lock};
+
+        // The render thread did not get to the last frame, so this one
+        // replaces it. Its scrolls and damage were not done yet, so keep
+        // them.
+        if (ready_frame.ready) {
+            dropped_frames++;
+            ready_frame.scrolls.insert(ready_frame.scrolls.end(),
+                                       pending_scrolls.begin(),
+                                       pending_scrolls.end());
+            ready_frame.damage.insert(ready_frame.damage.end(),
+                                      damaged.begin(), damaged.end());
+        } else {
+            ready_frame.scrolls.assign(pending_scrolls.begin(),
+                                       pending_scrolls.end());
+            ready_frame.damage.assign(damaged.begin(), damaged.end());
+        }
+
+        std::swap(buffer, ready_frame.pixels);
+        ready_frame.submitted = steady_clock::now();
+        ready_frame.ready = true;
+    }
 
-    // For each pixel
+    frame_ready.notify_one();
+
+    pending_scrolls.clear();
+    damaged.clear();
+    buffer.resize(size);
+}
+
+void TermScreen::start_render_thread() {
+    if (has_render_thread()) return;
+
+    render_thread_alive = true;
+    render_thread = std::thread{[this] { render_loop(); }};
+}
+
+void TermScreen::stop_render_thread() {
+    if (!has_render_thread()) return;
+
+    {
+        const std::lock_guard lock{frame_lock};
+        render_thread_alive = false;
+    }
+
+    frame_ready.notify_one();
+    render_thread.join();
+}
+
+void TermScreen::render_loop() {
+    using namespace std::chrono;
+
+    loguru::set_thread_name("render thread");
+    trace::set_thread_name("render thread");
+
+    while (true) {
+        {
+            std::unique_lock lock{frame_lock};
+            frame_ready.wait(lock, [this] {
+                return ready_frame.ready || !render_thread_alive;
+            });
+            if (!render_thread_alive) return;
+
+            // Take the frame, leaving the previous one to be drawn over
+            std::swap(ready_frame, render_frame);
+            ready_frame.ready = false;
+            ready_frame.scrolls.clear();
+            ready_frame.damage.clear();
+        }
+
+        {
+            const trace::Span span{"present", "term"};
+            const std::lock_guard lock{output_lock};
+            present(render_frame.pixels, render_frame.scrolls,
+                    render_frame.damage);
+        }
+
+        const auto latency = steady_clock::now() - render_frame.submitted;
+        metrics::commit_time.record(latency);
+        commit_latency =
+            static_cast<int>(duration_cast<microseconds>(latency).count());
+    }
+}
+
+bool TermScreen::present(span<const Pixel> pixels,
+                         span<const ScrollOp> scrolls,
+                         span<const Rect> damage) {
     const auto [w, h] = term.get_size();
+
+    // The size may have changed since the frame was drawn, so skip it if it
+    // does not match the terminal
+    if (pixels.size() != w * h) return false;
+
+    // The terminal holds rendering from the first change to the end of the
+    // frame, so that it never shows a half drawn screen
+    bool synced{};
+    const auto begin_sync = [&] {
+        if (synced) return;
+        term.begin_sync_update();
+        synced = true;
+    };
+
+    // Merge the damaged rectangles into a span of columns for each line
+    const Rect screen_rect{{}, {w, h}};
+    row_damage.assign(h, {});
+
+    const auto add_damage = [&](const Rect &rect) {
+        const auto r = rect.intersect(screen_rect);
+        const auto first = static_cast<usize>(r.left());
+        const auto last = static_cast<usize>(r.right() - 1);
+
+        for (auto j = r.top(); j < r.bottom(); j++) {
+            auto &row = row_damage[j];
+            row = row.dirty ? DirtySpan{std::min(row.first, first),
+                                        std::max(row.last, last), true}
+                            : DirtySpan{first, last, true};
+        }
+    };
+
+    for (const auto &rect : damage) add_damage(rect);
+
+    // If the size changed then we have no idea of what the terminal is
+    // showing, so clear it and start over with a blank front buffer.
+    if (front.size() != pixels.size()) {
+        begin_sync();
+        front.assign(pixels.size(), Pixel{});
+        scrolls = {};
+        cursor.reset();
+        term.clear_term();
+
+        add_damage(screen_rect);
+    }
+
+    // Let the terminal move the lines that it already has
+    if (!scrolls.empty()) {
+        begin_sync();
+        apply_scrolls(scrolls);
+    }
+
+    RenderStats frame;
+
     for (usize j{}; j < h; j++) {
-        for (usize i{}; i < w; i++) {
-            const auto new_style = ch->get_style();
-
-            if (prev_style != new_style) {
-                // Only print when the style changes (avoid re printing color
-                // control sequences many times)
-                flush_buffered(ch);
-                prev_style = new_style;
+        auto &span = row_damage[j];
+        if (!span.dirty) continue;
+
+        // Find what changed in the damaged part of the line (this is
+        // vectorized, so it is cheap even for huge terminals)
+        const auto base = ctoidx(span.first, j);
+        const auto n = span.last - span.first + 1;
+        const auto changed = diff_row(&pixels[base], &front[base], n);
+
+        frame.compared += n;
+        if (!changed.dirty) continue;
+
+        span = {span.first + changed.first, span.first + changed.last, true};
+
+        const uppr::span<const Pixel> front_row{&front[ctoidx(0, j)], w};
+
+        for (usize i{span.first}; i <= span.last; i++) {
+            const auto idx = ctoidx(i, j);
+            const auto &pixel = pixels[idx];
+
+            // Skip over everything that the terminal already shows
+            if (pixel == front[idx]) continue;
+
+            begin_sync();
+
+            // Get there in the cheapest way possible (this may even print
+            // again some of the cells that we skipped)
+            const CursorPos target{i, j};
+            if (cursor != target) {
+                const auto motion =
+                    plan_motion(cursor, target, front_row, term.get_style());
+                term.write(motion.view());
+
+                frame.motion_bytes += motion.size;
+                frame.motion_bytes_saved +=
+                    full_motion_size(target) - motion.size;
             }
 
-            // move to the next pixel
-            ch++;
+            // Only emits something when the style actually changes, and
+            // then only what is different
+            term.set_style(pixel.get_packed_style());
+
+            char encoded[4];
+            term.write({encoded, encode_utf8(pixel.get_glyph(), encoded)});
+            front[idx] = pixel;
+            frame.cells++;
+
+            // After the last column the cursor is left in a weird pending
+            // wrap state, so it is better to just forget about it
+            if (i + 1 < w)
+                cursor = CursorPos{i + 1, j};
+            else
+                cursor.reset();
         }
     }
 
-    flush_buffered(buffer.end());
+    stats.compared += frame.compared;
+
+    if (frame.cells) {
+        stats.frames++;
+        stats.cells += frame.cells;
+        stats.motion_bytes += frame.motion_bytes;
+        stats.motion_bytes_saved += frame.motion_bytes_saved;
+    }
+
+    stats.last_cells = frame.cells;
+    stats.last_motion_bytes = frame.motion_bytes;
+    stats.last_motion_bytes_saved = frame.motion_bytes_saved;
+
+    if (synced) term.end_sync_update();
     term.flush();
+
+    return true;
 }
 
-void TermScreen::setc(int x, int y, const Pixel &pixel) {
+bool TermScreen::scroll_region(const Transform &tl, const Size &size,
+                               int lines) {
     const auto [w, h] = term.get_size();
 
-    // Abort on invalid size
-    if (!valid_coords(w, h, x, y)) return;
+    if (tl.getx() < 0 || tl.gety() < 0) return false;
+
+    const auto x = static_cast<usize>(tl.getx());
+    const auto y = static_cast<usize>(tl.gety());
+    if (x >= w || y >= h) return false;
+
+    const auto rw = std::min<usize>(size.getx(), w - x);
+    const auto rh = std::min<usize>(size.gety(), h - y);
+    const auto n = static_cast<usize>(std::abs(lines));
+
+    // Scrolling everything out is just a repaint
+    if (lines == 0 || rw == 0 || n >= rh) return false;
+    if (rw != w && !term.get_lr_margins()) return false;
+
+    pending_scrolls.push_back({x, y, rw, rh, lines});
+    damage({tl, {rw, rh}});
+    mark_dirty();
+
+    return true;
+}
+
+void TermScreen::apply_scrolls(span<const ScrollOp> scrolls) {
+    for (const auto &op : scrolls) {
+        term.scroll_region(op.x, op.y, op.w, op.h, op.lines);
+
+        // Do the same to the front buffer, the exposed lines are blank
+        const auto n = static_cast<usize>(std::abs(op.lines));
+        const auto move_row = [&](usize dst, usize src) {
+            std::copy_n(&front[ctoidx(op.x, src)], op.w,
+                        &front[ctoidx(op.x, dst)]);
+        };
+
+        if (op.lines > 0) {
+            for (usize j{op.y}; j + n < op.y + op.h; j++) move_row(j, j + n);
+            for (usize j{op.y + op.h - n}; j < op.y + op.h; j++)
+                std::fill_n(&front[ctoidx(op.x, j)], op.w, Pixel{});
+        } else {
+            for (usize j{op.y + op.h - 1}; j >= op.y + n; j--)
+                move_row(j, j - n);
+            for (usize j{op.y}; j < op.y + n; j++)
+                std::fill_n(&front[ctoidx(op.x, j)], op.w, Pixel{});
+        }
+
+        stats.scrolls++;
+    }
+
+    // Changing the scroll margins moves the cursor home
+    cursor.reset();
+}
+
+void TermScreen::setc(int x, int y, const Pixel &pixel) {
+    canvas().setc(x, y, pixel);
+}
+
+void TermScreen::damage(const Rect &rect) {
+    const auto r = rect.intersect({{}, term.get_size()});
+    if (!r.empty()) damaged.push_back(r);
+}
+
+void TermScreen::push_layer(Surface &layer, Transform tl, Size size) {
+    layer.reset(tl, size);
+    layers.push_back(&layer);
+}
+
+void TermScreen::pop_layer() {
+    if (!layers.empty()) layers.pop_back();
+}
+
+void TermScreen::blit(const Surface &layer) {
+    auto c = canvas();
+
+    const auto [x, y] = layer.get_origin().get();
+    const auto [w, h] = layer.get_size().get();
+    const auto pixels = layer.get_pixels();
+
+    for (usize j{}; j < h; j++)
+        c.copy_row(x, y + static_cast<int>(j), pixels.subspan(j * w, w));
+}
 
-    buffer[ctoidx(x, y)] = pixel;
+TermScreen::Target TermScreen::target() {
     mark_dirty();
+
+    if (layers.empty()) return {buffer.data(), {{}, term.get_size()}};
+
+    auto &layer = *layers.back();
+    return {layer.get_pixels().data(),
+            {layer.get_origin(), layer.get_size()}};
 }
 
 void TermScreen::box(const Transform &tl, usize width, usize height,
@@ -77,74 +388,31 @@ void TermScreen::box(const Transform &tl, usize width, usize height,
 }
 
 void TermScreen::hline(int sx, int ex, int y, const Pixel &fill) {
-    const auto [w, h] = term.get_size();
-
-    // Abort on invalid coords and truncate lines that are to long
-    if (!valid_coords(w, h, sx, y)) return;
-    ex = std::min(ex, static_cast<int>(w));
-
-    for (; sx != ex; sx++) {
-        buffer[ctoidx(sx, y)] = fill;
-    }
+    canvas().hline(sx, ex, y, fill);
 }
 
 void TermScreen::vline(int x, int sy, int ey, const Pixel &fill) {
-    const auto [w, h] = term.get_size();
-
-    // Abort on invalid coords and truncate lines that are to long
-    if (!valid_coords(w, h, sy, ey)) return;
-    ey = std::min(ey, static_cast<int>(w));
-
-    for (; sy != ey; sy++) {
-        buffer[ctoidx(x, sy)] = fill;
-    }
+    canvas().vline(x, sy, ey, fill);
 }
 
 void TermScreen::vprint(int x, int y, fmt::string_view fmt,
                         fmt::format_args args) {
-    const auto [w, h] = term.get_size();
-    if (!valid_coords(w, h)) return;
-
-    const auto it = buffer.begin() + ctoidx(x, y);
-    fmt::vformat_to_n(it, w - x, fmt, args);
+    canvas().vprint(x, y, {}, fmt, args);
 }
 
 void TermScreen::vprint(int x, int y, fmt::text_style style,
                         fmt::string_view fmt, fmt::format_args args) {
-    const auto [w, h] = term.get_size();
-    if (!valid_coords(w, h)) return;
-
-    auto it = buffer.begin() + ctoidx(x, y);
-    const auto end = fmt::vformat_to_n(it, w - x, fmt, args);
-
-    for (; it != end.out; it++) {
-        it->set_style(style);
-    }
-}
-
-std::string TermScreen::inputline(Transform t, usize max_lenght) {
-    danger_cook_alt();
-    const auto input_transform = t;
-    raw_move_cursor(input_transform.getx(), input_transform.gety());
-
-    std::string str;
-    str.resize(max_lenght);
-    term.read(str);
-
-    // Trim on the ending newline
-    const auto newline = str.find('\n');
-    if (newline != std::string::npos)
-        str.resize(newline);
-
-    danger_uncook_alt();
-
-    return str;
+    canvas().vprint(x, y, style, fmt, args);
 }
 
 void TermScreen::update_size() {
     LOG_SCOPE_FUNCTION(9);
 
-    term.update_size();
+    {
+        const std::lock_guard lock{output_lock};
+        term.update_size();
+    }
+
     update_buffer_size();
 }
 
@@ -155,8 +423,9 @@ void TermScreen::clear() {
     w = std::max(w, 1UL);
     h = std::max(h, 1UL);
 
+    // A blank pixel is all zeroes, so this compiles to a `memset`
     buffer.resize(w * h);
-    std::ranges::fill(buffer, Pixel{});
+    std::fill(buffer.begin(), buffer.end(), Pixel{});
 
     mark_dirty();
 }
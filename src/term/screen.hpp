@@ -1,16 +1,82 @@
 #pragma once
 
 #include "box-options.hpp"
+#include "canvas.hpp"
 #include "fmt/color.h"
 #include "fmt/core.h"
 #include "pixel.hpp"
+#include "rect.hpp"
+#include "row-diff.hpp"
+#include "surface.hpp"
 #include "term.hpp"
 #include "vector2.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <termios.h>
+#include <thread>
 
 namespace uppr::term {
 
+/**
+ * Counters of the work done by `TermScreen::commit()`.
+ */
+struct RenderStats {
+    /**
+     * Number of commits that actually sent something.
+     */
+    usize frames{};
+
+    /**
+     * Total number of cells printed.
+     */
+    usize cells{};
+
+    /**
+     * Total bytes used for moving the cursor.
+     */
+    usize motion_bytes{};
+
+    /**
+     * Total bytes saved by the motion planner, compared to always using
+     * absolute positioning.
+     */
+    usize motion_bytes_saved{};
+
+    /**
+     * Total number of cells compared with what the terminal shows. Only
+     * damaged cells are compared.
+     */
+    usize compared{};
+
+    /**
+     * Total number of regions scrolled by the terminal itself.
+     */
+    usize scrolls{};
+
+    /**
+     * Frames replaced by a newer one before the render thread got to them.
+     */
+    usize dropped_frames{};
+
+    /**
+     * Number of cells printed by the last commit.
+     */
+    usize last_cells{};
+
+    /**
+     * Bytes used for moving the cursor by the last commit.
+     */
+    usize last_motion_bytes{};
+
+    /**
+     * Bytes saved by the motion planner in the last commit.
+     */
+    usize last_motion_bytes_saved{};
+};
+
 /**
  * Add a buffer between the terminal driver and user code, so that more
  * interesting things can be done in a way more eficient way then direct
@@ -30,13 +96,64 @@ public:
         term.clear_term();
     }
 
+    /**
+     * Construct a headless screen of a fixed size that writes to the given
+     * file descriptor. See the headless `Term` constructors.
+     */
+    TermScreen(Size size, int output_file_descr)
+        : term{size, output_file_descr} {
+        update_buffer_size();
+        term.clear_term();
+    }
+
+    /**
+     * Construct a headless screen of a fixed size that hands all output to
+     * the given sink.
+     */
+    TermScreen(Size size, OutputSink sink) : term{size, std::move(sink)} {
+        update_buffer_size();
+        term.clear_term();
+    }
+
+    ~TermScreen();
+
     /**
      * Actually commit the buffer to the terminal screen.
      *
-     * If the `dirty` flag is not set, then this call has absolutally no effect.
+     * Only the cells that differ from what the terminal is already showing
+     * (the `front` buffer) are sent, and only the cells inside of rectangles
+     * given to `damage()` since the last commit are looked at. If the `dirty`
+     * flag is not set, then this call has absolutally no effect.
+     *
+     * With the render thread running, the buffer is only handed off to it and
+     * its contents are undefined afterwards (so `clear()` it before drawing
+     * again). If the render thread is still busy with the previous frame when
+     * the next one arrives, then the previous one is dropped.
      */
     void commit();
 
+    /**
+     * Start committing frames from a separate thread, so that slow terminal
+     * writes don't stall the caller of `commit()`.
+     */
+    void start_render_thread();
+
+    /**
+     * Stop the render thread, going back to committing synchronously.
+     */
+    void stop_render_thread();
+
+    /**
+     * If the render thread is running.
+     */
+    bool has_render_thread() const noexcept { return render_thread.joinable(); }
+
+    /**
+     * Time between the last presented frame being committed and it being
+     * fully sent to the terminal, in microseconds.
+     */
+    int get_commit_latency() const noexcept { return commit_latency; }
+
 public:
     /**
      * Get the size of the terminal.
@@ -48,11 +165,41 @@ public:
      */
     char readc() const { return term.readc(); }
 
+    /**
+     * Get the file descriptor that input is read from (see
+     * `Term::get_input_fd()`).
+     */
+    constexpr int get_input_fd() const { return term.get_input_fd(); }
+
     /**
      * Read a single character from the terminal.
      */
     string_view read(span<char> buf) const { return term.read(buf); }
 
+    /**
+     * Get the pixels drawn so far, row by row.
+     */
+    span<const Pixel> get_buffer() const noexcept { return buffer; }
+
+    /**
+     * Get a canvas for drawing to the whole of the current target (the top
+     * layer, or the buffer).
+     */
+    Canvas canvas() {
+        const auto t = target();
+        return {t.pixels, t.rect, {}, term.get_size(), t.rect};
+    }
+
+    /**
+     * Get a canvas for drawing to the rectangle at `tl` with the given size,
+     * with coordinates relative to `tl`. Usually done by a scene with the
+     * transform and size that it got.
+     */
+    Canvas canvas(Transform tl, Size size) {
+        const auto t = target();
+        return {t.pixels, t.rect, tl, size, {tl, size}};
+    }
+
     /**
      * Set a pixel in the buffer at the given coordinates.
      */
@@ -133,13 +280,47 @@ public:
                 fmt::format_args args);
 
     /**
-     * Read a line from the user. **DANGEROUS**!
+     * Scroll the rectangle at `tl` of the given size up by `lines` (or down,
+     * if negative), both in the terminal and in what we know that it shows.
      *
-     * This function completally removes the spacial _uncooked_ handling of the
-     * terminal for getting text input. If the user sends a signal like `ctrl+c`
-     * while this is active, then the program dies horribly!
+     * The scroll is done at the start of the next `commit()`, so that only
+     * the exposed lines need to be sent. The buffer must still be drawn in
+     * full as usual. Returns `false` (and does nothing) when the terminal
+     * can not scroll that rectangle.
+     */
+    bool scroll_region(const Transform &tl, const Size &size, int lines);
+
+    /**
+     * Say that the given rectangle (in screen coordinates) may have changed
+     * since the last commit, so that `commit()` compares it with what the
+     * terminal shows. Anything never damaged is assumed to be the same.
+     */
+    void damage(const Rect &rect);
+
+    /**
+     * Say that everything may have changed since the last commit.
      */
-    std::string inputline(Transform t, usize max_length);
+    void damage_all() { damage({{}, term.get_size()}); }
+
+    /**
+     * Draw to `layer` instead of the screen until `pop_layer()`.
+     *
+     * The layer is reset to cover the rectangle at `tl` with the given size
+     * with transparent pixels, and drawing outside of it is discarded. Layers
+     * can be nested.
+     */
+    void push_layer(Surface &layer, Transform tl, Size size);
+
+    /**
+     * Go back to drawing wherever we were before the last `push_layer()`.
+     */
+    void pop_layer();
+
+    /**
+     * Copy everything that was drawn on `layer` to the current target,
+     * leaving the transparent pixels alone.
+     */
+    void blit(const Surface &layer);
 
 public:
     /**
@@ -153,43 +334,124 @@ public:
 
     /**
      * Update the size of terminal.
-     *
-     * This should be called from the `SIGWINCH` signal to update based on
-     * real-time changes.
      */
     void update_size();
 
     /**
-     * Clear the screen.
+     * Ask for the size to be updated on the next `poll_resize()`.
+     *
+     * This is safe to call from the `SIGWINCH` signal handler.
      */
-    void clear();
+    void notify_resize() noexcept { resize_requested = true; }
 
     /**
-     * Exit uncooked mode for text input.
+     * If `notify_resize()` was called and the size was not updated yet.
      */
-    void danger_uncook() { term.danger_uncook(); }
+    bool resize_pending() const noexcept { return resize_requested; }
 
     /**
-     * Enter uncooked mode for text input.
+     * Update the size of the terminal if `notify_resize()` was called.
      */
-    void danger_cook() { term.danger_cook(); }
+    void poll_resize() {
+        if (resize_requested.exchange(false)) update_size();
+    }
 
     /**
-     * Exit uncooked mode for text input.
+     * Clear the screen.
      */
-    void danger_uncook_alt() { term.danger_uncook_and_preserve_alt(); }
+    void clear();
 
     /**
-     * Enter uncooked mode for text input.
+     * Forget what the terminal is showing, so that the next commit repaints
+     * everything.
      */
-    void danger_cook_alt() { term.danger_cook_with_preserved_alt(); }
+    void invalidate() {
+        const std::lock_guard lock{output_lock};
+        invalidate_front();
+    }
 
     /**
      * Move the cursor directly inside the screen.
+     *
+     * This goes straight to the terminal, skipping the frame buffering.
      */
-    void raw_move_cursor(usize x, usize y) const { term.move_cursor(x, y); }
+    void raw_move_cursor(usize x, usize y) {
+        const std::lock_guard lock{output_lock};
+        term.move_cursor(x, y);
+        term.flush();
+    }
+
+    /**
+     * Get the counters of bytes and syscalls used to write to the terminal.
+     */
+    OutputStats get_output_stats() const {
+        const std::lock_guard lock{output_lock};
+        return term.get_output_stats();
+    }
+
+    /**
+     * Get the counters of cells and cursor motions sent by `commit()`.
+     */
+    RenderStats get_render_stats() const {
+        const std::lock_guard lock{output_lock};
+
+        auto copy = stats;
+        copy.dropped_frames = dropped_frames;
+
+        return copy;
+    }
 
 private:
+    /**
+     * A scroll requested with `scroll_region()`, waiting for the next commit.
+     */
+    struct ScrollOp {
+        usize x, y, w, h;
+        int lines;
+    };
+
+    /**
+     * A complete frame handed off to the render thread.
+     */
+    struct Frame {
+        std::vector<Pixel> pixels;
+        std::vector<ScrollOp> scrolls;
+        std::vector<Rect> damage;
+        std::chrono::steady_clock::time_point submitted;
+        bool ready{};
+    };
+
+    /**
+     * Send the differences between `pixels` and `front` inside of the
+     * `damage` rectangles to the terminal. Returns `false` if the frame does
+     * not match the size of the terminal.
+     *
+     * Must be called with `output_lock` held.
+     */
+    bool present(span<const Pixel> pixels, span<const ScrollOp> scrolls,
+                 span<const Rect> damage);
+
+    /**
+     * Do the given scrolls on the terminal and on the `front` buffer.
+     */
+    void apply_scrolls(span<const ScrollOp> scrolls);
+
+    /**
+     * Forget what the terminal is showing. Must be called with `output_lock`
+     * held.
+     */
+    void invalidate_front() {
+        front.clear();
+        pending_scrolls.clear();
+        cursor.reset();
+        mark_dirty();
+    }
+
+    /**
+     * Main loop of the render thread.
+     */
+    void render_loop();
+
     /**
      * Update the size of the pixel buffer to match the size of the terminal.
      */
@@ -206,19 +468,18 @@ private:
     }
 
     /**
-     * If the given coordinates are valid.
+     * Where drawing goes to, in screen coordinates.
      */
-    constexpr bool valid_coords(int x, int y) const noexcept {
-        const auto [w, h] = term.get_size();
-        return valid_coords(w, h, x, y);
-    }
+    struct Target {
+        Pixel *pixels;
+        Rect rect;
+    };
 
     /**
-     * If the given coordinates are valid with the given width and height.
+     * Get what we are drawing to: the top layer, or the buffer. This also
+     * marks the screen as dirty, as it is only asked for to draw.
      */
-    constexpr bool valid_coords(usize w, usize h, int x, int y) const noexcept {
-        return x >= 0 && y >= 0 && x <= w && y <= h;
-    }
+    Target target();
 
     /**
      * If we need to actually re-print everything to the terminal.
@@ -242,11 +503,103 @@ private:
      */
     std::vector<Pixel> buffer;
 
+    /**
+     * What the terminal is currently showing, as of the last commit. This is
+     * compared with `buffer` to only send the cells that changed.
+     *
+     * When empty (or of a different size), the next commit clears the terminal
+     * and repaints everything.
+     */
+    std::vector<Pixel> front;
+
+    /**
+     * Layers pushed with `push_layer()`. Drawing goes to the last one.
+     */
+    std::vector<Surface *> layers;
+
+    /**
+     * Rectangles given to `damage()` since the last commit.
+     */
+    std::vector<Rect> damaged;
+
+    /**
+     * The span of columns that were damaged in each line, and then the span
+     * that actually changed, found when committing. Kept around so that it is
+     * not reallocated every frame.
+     */
+    std::vector<DirtySpan> row_damage;
+
+    /**
+     * Scrolls to be done at the start of the next commit, in order.
+     */
+    std::vector<ScrollOp> pending_scrolls;
+
+    /**
+     * Where the terminal cursor is, if we know it.
+     */
+    optional<CursorPos> cursor;
+
+    /**
+     * Counters for `commit()`.
+     */
+    RenderStats stats;
+
     /**
      * An optimization to not re-draw frames that are exactly the same.
      */
     bool dirty{true};
 
+    /**
+     * Held by whoever is writing to the terminal or touching `front`.
+     */
+    mutable std::mutex output_lock;
+
+    /**
+     * The last frame committed, waiting for the render thread. Protected by
+     * `frame_lock`.
+     */
+    Frame ready_frame;
+
+    /**
+     * The frame that the render thread is presenting.
+     */
+    Frame render_frame;
+
+    /**
+     * Protects `ready_frame` and `render_thread_alive`.
+     */
+    std::mutex frame_lock;
+
+    /**
+     * Wakes the render thread when a frame is ready.
+     */
+    std::condition_variable frame_ready;
+
+    /**
+     * If the render thread should keep running.
+     */
+    bool render_thread_alive{};
+
+    /**
+     * The render thread, if any.
+     */
+    std::thread render_thread;
+
+    /**
+     * Counter of frames that were dropped before being presented.
+     */
+    std::atomic<usize> dropped_frames{};
+
+    /**
+     * Latency of the last commit, in microseconds.
+     */
+    std::atomic<int> commit_latency{};
+
+    /**
+     * Set by `notify_resize()`.
+     */
+    std::atomic<bool> resize_requested{};
+
     /**
      * The actual terminal driver.
      */
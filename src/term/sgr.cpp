@@ -0,0 +1,411 @@
+#include "sgr.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+namespace uppr::term {
+
+namespace {
+
+/**
+ * Every `fmt::emphasis` flag (by bit index) with the SGR codes that turn it on
+ * and off. Note that bold and faint are both turned off by the same code.
+ */
+constexpr array<std::pair<u8, u8>, 8> emphasis_codes{{
+    {1, 22}, // bold
+    {2, 22}, // faint
+    {3, 23}, // italic
+    {4, 24}, // underline
+    {5, 25}, // blink
+    {7, 27}, // reverse
+    {8, 28}, // conceal
+    {9, 29}, // strikethrough
+}};
+
+constexpr u8 bold_faint_mask = 0b11;
+
+/**
+ * The default colors of the 16 color palette in xterm, which most terminals
+ * are close to.
+ */
+constexpr array<u32, 16> ansi16_palette{{
+    0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD,
+    0xE5E5E5, 0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF,
+    0x00FFFF, 0xFFFFFF,
+}};
+
+/**
+ * Get the RGB value of a color of the 256 color palette that is not one of
+ * the first 16 (which are whatever the terminal wants).
+ */
+constexpr u32 ansi256_rgb(usize idx) {
+    if (idx >= 232) {
+        const u32 gray = 8 + 10 * (idx - 232);
+        return gray << 16 | gray << 8 | gray;
+    }
+
+    constexpr array<u32, 6> levels{{0, 95, 135, 175, 215, 255}};
+    idx -= 16;
+
+    return levels[idx / 36] << 16 | levels[idx / 6 % 6] << 8 | levels[idx % 6];
+}
+
+/**
+ * Colors are looked up with 5 bits per channel, which is way more precise
+ * than either palette.
+ */
+constexpr usize lut_bits = 5;
+constexpr usize lut_size = 1 << (lut_bits * 3);
+
+/**
+ * Table of the nearest palette color for every quantized RGB color.
+ */
+using PaletteLut = array<u8, lut_size>;
+
+constexpr usize lut_index(u32 rgb) {
+    constexpr auto drop = 8 - lut_bits;
+
+    return ((rgb >> 16 & 0xFF) >> drop) << (lut_bits * 2) |
+           ((rgb >> 8 & 0xFF) >> drop) << lut_bits | ((rgb & 0xFF) >> drop);
+}
+
+/**
+ * Distance between two colors, weighted a bit towards green as eyes are more
+ * sensitive to it.
+ */
+constexpr u32 color_distance(u32 a, u32 b) {
+    const auto d = [&](u32 shift) {
+        const auto x = static_cast<int>(a >> shift & 0xFF) -
+                       static_cast<int>(b >> shift & 0xFF);
+        return static_cast<u32>(x * x);
+    };
+
+    return 2 * d(16) + 4 * d(8) + 3 * d(0);
+}
+
+/**
+ * Build the table with `nearest(rgb)` giving the palette index for the center
+ * of each bucket of colors that share a key.
+ */
+template <typename F>
+PaletteLut build_lut(F &&nearest) {
+    constexpr auto drop = 8 - lut_bits;
+    constexpr u32 half = 1 << (drop - 1);
+
+    PaletteLut lut{};
+    for (usize key{}; key < lut_size; key++) {
+        const u32 r = (key >> (lut_bits * 2) & 0x1F) << drop | half;
+        const u32 g = (key >> lut_bits & 0x1F) << drop | half;
+        const u32 b = (key & 0x1F) << drop | half;
+
+        lut[key] = nearest(r << 16 | g << 8 | b);
+    }
+
+    return lut;
+}
+
+/**
+ * Find the nearest of the palette colors from `first` to `last` by trying
+ * all of them.
+ */
+u8 nearest_of(u32 rgb, usize first, usize last, u32 (*rgb_of)(usize)) {
+    usize best = first;
+    u32 best_distance = ~0U;
+    for (usize idx{first}; idx <= last; idx++) {
+        const auto dist = color_distance(rgb, rgb_of(idx));
+        if (dist < best_distance) {
+            best = idx;
+            best_distance = dist;
+        }
+    }
+
+    return static_cast<u8>(best);
+}
+
+/**
+ * Get the nearest color of the 16 color palette. The table is only built on
+ * first use (only terminals with that depth need it).
+ */
+u8 nearest_ansi16(u32 rgb) {
+    static const auto lut = build_lut([](u32 rgb) {
+        return nearest_of(rgb, 0, 15,
+                          [](usize idx) { return ansi16_palette[idx]; });
+    });
+
+    return lut[lut_index(rgb)];
+}
+
+/**
+ * Get the nearest color of the 256 color palette, skipping the first 16 as
+ * their actual values are not known.
+ */
+u8 nearest_ansi256(u32 rgb) {
+    static const auto lut = build_lut([](u32 rgb) {
+        // The distance is a sum over the channels, so the nearest color of
+        // the cube is just the nearest level of each channel
+        const auto level = [&](u32 shift) -> usize {
+            const auto v = rgb >> shift & 0xFF;
+            if (v < 48) return 0;
+            if (v < 115) return 1;
+
+            return (v - 35) / 40;
+        };
+
+        const auto cube = 16 + level(16) * 36 + level(8) * 6 + level(0);
+        const auto gray = nearest_of(rgb, 232, 255, ansi256_rgb);
+
+        return color_distance(rgb, ansi256_rgb(cube)) <=
+                       color_distance(rgb, ansi256_rgb(gray))
+                   ? static_cast<u8>(cube)
+                   : gray;
+    });
+
+    return lut[lut_index(rgb)];
+}
+
+/**
+ * A color as it is actually sent to a terminal of some color depth.
+ */
+struct ColorCode {
+    enum class Kind : u8 { none, basic, indexed, rgb };
+
+    Kind kind{};
+
+    /**
+     * The foreground SGR code for `basic`, the palette index for `indexed`
+     * and the 24 bit value for `rgb`.
+     */
+    u32 value{};
+
+    constexpr bool operator==(const ColorCode &) const = default;
+};
+
+/**
+ * Get how a packed color (as in `PackedStyle::fg_bits()`) is sent.
+ */
+ColorCode encode_color(u64 bits, ColorDepth depth) {
+    using Kind = ColorCode::Kind;
+
+    if (!(bits & PackedStyle::color_set_bit)) return {};
+
+    // `fmt::terminal_color` values are already the foreground codes
+    if (!(bits & PackedStyle::color_rgb_bit))
+        return {Kind::basic, static_cast<u32>(bits & 0xFF)};
+
+    const auto rgb = static_cast<u32>(bits & PackedStyle::color_value_mask);
+    switch (depth) {
+    case ColorDepth::ansi16: {
+        const auto idx = nearest_ansi16(rgb);
+        return {Kind::basic, idx < 8 ? 30u + idx : 90u + idx - 8};
+    }
+    case ColorDepth::ansi256:
+        return {Kind::indexed, nearest_ansi256(rgb)};
+    default:
+        return {Kind::rgb, rgb};
+    }
+}
+
+/**
+ * Appends `;`-separated parameters into a buffer.
+ */
+class ParamWriter {
+public:
+    explicit ParamWriter(char *o) : out{o} {}
+
+    void number(u32 n) {
+        separate();
+        out = std::to_chars(out, out + 3, n).ptr;
+    }
+
+    /**
+     * Add the parameters for a color.
+     *
+     * @param base Either 30 for foreground or 40 for background.
+     */
+    void color(ColorCode c, u32 base) {
+        using Kind = ColorCode::Kind;
+
+        switch (c.kind) {
+        case Kind::none:
+            // default color
+            number(base + 9);
+            break;
+        case Kind::basic:
+            number(c.value + (base - 30));
+            break;
+        case Kind::indexed:
+            number(base + 8);
+            number(5);
+            number(c.value);
+            break;
+        case Kind::rgb:
+            number(base + 8);
+            number(2);
+            number((c.value >> 16) & 0xFF);
+            number((c.value >> 8) & 0xFF);
+            number(c.value & 0xFF);
+            break;
+        }
+    }
+
+    bool empty() const noexcept { return first; }
+    char *end() const noexcept { return out; }
+
+private:
+    void separate() {
+        if (!first) *out++ = ';';
+        first = false;
+    }
+
+    char *out;
+    bool first{true};
+};
+
+/**
+ * Wrap the parameters written by `fill` into `CSI ... m`.
+ */
+template <typename F>
+usize write_sequence(char *out, F &&fill) {
+    out[0] = '\x1B';
+    out[1] = '[';
+
+    ParamWriter w{out + 2};
+    fill(w);
+
+    // No parameters means nothing to do
+    if (w.empty()) return 0;
+
+    *w.end() = 'm';
+    return w.end() + 1 - out;
+}
+} // namespace
+
+ColorDepth color_depth_from_env(const char *colorterm, const char *term) {
+    const string_view ct{colorterm ? colorterm : ""};
+    const string_view t{term ? term : ""};
+
+    if (ct == "truecolor" || ct == "24bit") return ColorDepth::truecolor;
+    if (t.ends_with("-direct")) return ColorDepth::truecolor;
+    if (t.find("256color") != string_view::npos) return ColorDepth::ansi256;
+
+    return ColorDepth::ansi16;
+}
+
+string_view color_depth_name(ColorDepth depth) {
+    switch (depth) {
+    case ColorDepth::ansi16: return "16 colors";
+    case ColorDepth::ansi256: return "256 colors";
+    default: return "truecolor";
+    }
+}
+
+string_view SgrCache::transition(PackedStyle from, PackedStyle to) {
+    if (from == to) return {};
+
+    // Dont let the table get too full, as probing gets slow. In practice this
+    // only happens if something is generating lots of different colors.
+    if (used >= capacity * 3 / 4) {
+        table = {};
+        used = 0;
+    }
+
+    auto idx = hash(from.bits(), to.bits());
+    while (table[idx].used) {
+        auto &e = table[idx];
+        if (e.from == from.bits() && e.to == to.bits()) {
+            hits++;
+            return {e.bytes.data(), e.size};
+        }
+
+        idx = (idx + 1) & (capacity - 1);
+    }
+
+    // Not found, so format it once into the free slot
+    misses++;
+    used++;
+
+    auto &e = table[idx];
+    e.used = true;
+    e.from = from.bits();
+    e.to = to.bits();
+    e.size = format(from, to, depth, e.bytes.data());
+
+    return {e.bytes.data(), e.size};
+}
+
+usize SgrCache::format(PackedStyle from, PackedStyle to, ColorDepth depth,
+                       char *out) {
+    const auto full_size = format_full(to, depth, out);
+    if (from == unknown) return full_size;
+
+    // Try the delta, and only keep it if it is shorter than a full reset
+    array<char, max_sequence_size> delta;
+    const auto delta_size = write_sequence(delta.data(), [&](ParamWriter &w) {
+        const u8 old_ems = from.emphasis();
+        const u8 new_ems = to.emphasis();
+
+        // If bold or faint was removed, the shared off code removes both, so
+        // the one that stays has to be added back
+        u8 readd{};
+        if ((old_ems & ~new_ems) & bold_faint_mask) {
+            w.number(22);
+            readd = new_ems & old_ems & bold_faint_mask;
+        }
+
+        for (usize bit{}; bit < emphasis_codes.size(); bit++) {
+            const u8 mask = 1 << bit;
+            const auto [on, off] = emphasis_codes[bit];
+
+            if (mask & bold_faint_mask) {
+                if ((new_ems & ~old_ems & mask) || (readd & mask))
+                    w.number(on);
+            } else if (new_ems & ~old_ems & mask) {
+                w.number(on);
+            } else if (old_ems & ~new_ems & mask) {
+                w.number(off);
+            }
+        }
+
+        // Different RGB colors can end up as the same palette color, so
+        // compare what is actually sent
+        const auto fg = encode_color(to.fg_bits(), depth);
+        const auto bg = encode_color(to.bg_bits(), depth);
+
+        if (encode_color(from.fg_bits(), depth) != fg) w.color(fg, 30);
+        if (encode_color(from.bg_bits(), depth) != bg) w.color(bg, 40);
+    });
+
+    if (delta_size < full_size) {
+        std::memcpy(out, delta.data(), delta_size);
+        return delta_size;
+    }
+
+    return full_size;
+}
+
+usize SgrCache::format_full(PackedStyle to, ColorDepth depth, char *out) {
+    const auto size = write_sequence(out, [&](ParamWriter &w) {
+        // `CSI m` is the same as `CSI 0 m`, so the reset is implicit when
+        // there is nothing else to set
+        if (to == PackedStyle{}) return;
+
+        w.number(0);
+
+        const u8 ems = to.emphasis();
+        for (usize bit{}; bit < emphasis_codes.size(); bit++) {
+            if (ems & (1 << bit)) w.number(emphasis_codes[bit].first);
+        }
+
+        if (to.has_fg()) w.color(encode_color(to.fg_bits(), depth), 30);
+        if (to.has_bg()) w.color(encode_color(to.bg_bits(), depth), 40);
+    });
+
+    if (size) return size;
+
+    // Plain reset
+    std::memcpy(out, "\x1B[m", 3);
+    return 3;
+}
+} // namespace uppr::term
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "commom.hpp"
+#include "style.hpp"
+
+namespace uppr::term {
+
+/**
+ * How many colors the terminal can show, which decides how colors are sent.
+ */
+enum class ColorDepth : u8 {
+    /**
+     * Only the 8 basic colors and their bright versions (`30`-`37` and
+     * `90`-`97`). RGB colors are sent as the nearest of those.
+     */
+    ansi16,
+
+    /**
+     * The xterm 256 color palette (`38;5;n`). RGB colors are sent as the
+     * nearest color of the 6x6x6 cube or of the gray ramp.
+     */
+    ansi256,
+
+    /**
+     * 24 bit RGB colors (`38;2;r;g;b`), sent as they are.
+     */
+    truecolor,
+};
+
+/**
+ * Guess the color depth from the values of the `COLORTERM` and `TERM`
+ * environment variables (either may be null).
+ */
+ColorDepth color_depth_from_env(const char *colorterm, const char *term);
+
+/**
+ * Get the name of a color depth, for logging.
+ */
+string_view color_depth_name(ColorDepth depth);
+
+/**
+ * Cache of SGR (Select Graphic Rendition) escape sequences.
+ *
+ * Going from one style to another is formatted only once, and then reused as a
+ * precomputed byte string every time that same transition happens again. The
+ * UI only has a handful of styles, so after the first few frames all style
+ * changes are a single table lookup.
+ *
+ * The sequences are minimal deltas: only what changed between the two styles
+ * is emitted (for example, just the new foreground), falling back to a reset
+ * plus the full style only when that is shorter.
+ *
+ * Colors are sent in the shortest form for the color depth of the terminal,
+ * see `set_depth()`. RGB colors are quantized with a precomputed table when
+ * the terminal can't show them.
+ */
+class SgrCache {
+public:
+    /**
+     * A style that never matches a real one. Use it when what the terminal is
+     * using is not known, so that the transition is a full reset.
+     */
+    static constexpr PackedStyle unknown = PackedStyle::from_bits(~0ULL);
+
+    /**
+     * Maximum size of a single sequence. The worst case is a reset with all
+     * emphasis flags and two RGB colors, which is a bit less than this.
+     */
+    static constexpr usize max_sequence_size = 64;
+
+    /**
+     * Number of slots in the table. Must be a power of two.
+     */
+    static constexpr usize capacity = 256;
+
+public:
+    /**
+     * Get the escape sequence to go from style `from` to style `to`.
+     *
+     * The returned view is valid until the next call.
+     */
+    string_view transition(PackedStyle from, PackedStyle to);
+
+    /**
+     * Change how colors are sent. This forgets every cached transition.
+     */
+    void set_depth(ColorDepth d) {
+        depth = d;
+        table = {};
+        used = 0;
+    }
+
+    /**
+     * Get how colors are sent.
+     */
+    ColorDepth get_depth() const noexcept { return depth; }
+
+    /**
+     * How many transitions had to be formatted (cache misses).
+     */
+    usize get_misses() const noexcept { return misses; }
+
+    /**
+     * How many transitions were found in the table (cache hits).
+     */
+    usize get_hits() const noexcept { return hits; }
+
+private:
+    struct Entry {
+        u64 from;
+        u64 to;
+        u8 size;
+        bool used;
+        array<char, max_sequence_size> bytes;
+    };
+
+    /**
+     * Format the escape sequence to go from `from` to `to` into `out`.
+     *
+     * @return How many bytes were written.
+     */
+    static usize format(PackedStyle from, PackedStyle to, ColorDepth depth,
+                        char *out);
+
+    /**
+     * Format a reset followed by the full style into `out`.
+     *
+     * @return How many bytes were written.
+     */
+    static usize format_full(PackedStyle to, ColorDepth depth, char *out);
+
+    /**
+     * Mix both styles into a table index.
+     */
+    static constexpr usize hash(u64 from, u64 to) noexcept {
+        auto h = from * 0x9E3779B97F4A7C15ULL ^ (to + 0x632BE59BD9B4E019ULL);
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 32;
+
+        return h & (capacity - 1);
+    }
+
+private:
+    /**
+     * Open addressing table (linear probing) of known transitions.
+     */
+    array<Entry, capacity> table{};
+
+    /**
+     * Number of used slots in `table`.
+     */
+    usize used{};
+
+    ColorDepth depth{ColorDepth::truecolor};
+
+    usize hits{};
+    usize misses{};
+};
+} // namespace uppr::term
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "commom.hpp"
+#include "fmt/color.h"
+
+namespace uppr::term {
+
+/**
+ * A text style (foreground, background and emphasis) packed in a single 64 bit
+ * word, so that it is trivially copyable and cheap to compare and hash.
+ *
+ * The layout of the word is:
+ * ```
+ *  63    60 59      52 51 50 49      26 25 24 23       0
+ * +--------+----------+-----+----------+-----+----------+
+ * | unused | emphasis | bg  | bg value | fg  | fg value |
+ * +--------+----------+-----+----------+-----+----------+
+ * ```
+ *
+ * Each color has a _set_ bit and an _is rgb_ bit, and its value is either a
+ * 24 bit RGB color or an ANSI terminal color code.
+ *
+ * A zero word is the default style (no colors and no emphasis).
+ */
+class PackedStyle {
+public:
+    static constexpr u64 color_bits = 26;
+    static constexpr u64 color_value_mask = 0xFFFFFF;
+    static constexpr u64 color_set_bit = 1 << 24;
+    static constexpr u64 color_rgb_bit = 1 << 25;
+    static constexpr u64 color_mask = (1 << color_bits) - 1;
+
+    static constexpr u64 fg_shift = 0;
+    static constexpr u64 bg_shift = color_bits;
+    static constexpr u64 emphasis_shift = color_bits * 2;
+
+    /**
+     * Constructs the default style.
+     */
+    constexpr PackedStyle() = default;
+
+    /**
+     * Pack a fmt style.
+     */
+    constexpr PackedStyle(const fmt::text_style &s) {
+        if (s.has_foreground()) word |= pack_color(s.get_foreground());
+        if (s.has_background())
+            word |= pack_color(s.get_background()) << bg_shift;
+        if (s.has_emphasis())
+            word |= static_cast<u64>(s.get_emphasis()) << emphasis_shift;
+    }
+
+    /**
+     * Reinterpret a raw packed word.
+     */
+    static constexpr PackedStyle from_bits(u64 bits) {
+        PackedStyle s;
+        s.word = bits;
+
+        return s;
+    }
+
+public:
+    /**
+     * Unpack back into a fmt style.
+     */
+    constexpr fmt::text_style to_text_style() const {
+        fmt::text_style s{static_cast<fmt::emphasis>(emphasis())};
+
+        if (has_fg()) s |= fmt::fg(unpack_color(fg_bits()));
+        if (has_bg()) s |= fmt::bg(unpack_color(bg_bits()));
+
+        return s;
+    }
+
+    constexpr operator fmt::text_style() const { return to_text_style(); }
+
+    /**
+     * Get the raw packed word.
+     */
+    constexpr u64 bits() const noexcept { return word; }
+
+    /**
+     * Get the packed foreground color (value, set and rgb bits).
+     */
+    constexpr u64 fg_bits() const noexcept {
+        return (word >> fg_shift) & color_mask;
+    }
+
+    /**
+     * Get the packed background color (value, set and rgb bits).
+     */
+    constexpr u64 bg_bits() const noexcept {
+        return (word >> bg_shift) & color_mask;
+    }
+
+    /**
+     * Get the emphasis flags (as in `fmt::emphasis`).
+     */
+    constexpr u8 emphasis() const noexcept {
+        return static_cast<u8>(word >> emphasis_shift);
+    }
+
+    constexpr bool has_fg() const noexcept { return fg_bits() & color_set_bit; }
+    constexpr bool has_bg() const noexcept { return bg_bits() & color_set_bit; }
+
+    // Compare objects
+    constexpr bool operator==(const PackedStyle &) const = default;
+
+public:
+    /**
+     * Pack a single fmt color into the lower 26 bits.
+     */
+    static constexpr u64 pack_color(fmt::detail::color_type c) noexcept {
+        if (c.is_rgb)
+            return color_set_bit | color_rgb_bit |
+                   (c.value.rgb_color & color_value_mask);
+
+        return color_set_bit | c.value.term_color;
+    }
+
+    /**
+     * Unpack a color packed with `pack_color`.
+     */
+    static constexpr fmt::detail::color_type unpack_color(u64 bits) noexcept {
+        if (bits & color_rgb_bit)
+            return fmt::rgb{static_cast<u32>(bits & color_value_mask)};
+
+        return static_cast<fmt::terminal_color>(bits & 0xFF);
+    }
+
+private:
+    u64 word{};
+};
+} // namespace uppr::term
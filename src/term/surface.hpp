@@ -0,0 +1,60 @@
+#pragma once
+
+#include "commom.hpp"
+#include "pixel.hpp"
+#include "vector2.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace uppr::term {
+
+/**
+ * An off-screen rectangle of pixels.
+ *
+ * Drawing to a surface is done with `TermScreen::push_layer()`, and the result
+ * is copied to the screen with `TermScreen::blit()`. That way, a scene that
+ * did not change can blit what it drew before instead of drawing again.
+ *
+ * Pixels that were not drawn to stay transparent, so they don't cover
+ * whatever is below them when blitted.
+ */
+class Surface {
+public:
+    /**
+     * Cover the given rectangle (in screen coordinates) with transparent
+     * pixels.
+     */
+    void reset(Transform tl, Size s) {
+        origin = tl;
+        size = s;
+
+        pixels.assign(size.getx() * size.gety(), Pixel::transparent());
+    }
+
+    /**
+     * Get the screen coordinates of the top left corner.
+     */
+    constexpr Transform get_origin() const noexcept { return origin; }
+
+    /**
+     * Get the size of the surface.
+     */
+    constexpr Size get_size() const noexcept { return size; }
+
+    /**
+     * Get all the pixels, row by row.
+     */
+    span<Pixel> get_pixels() noexcept { return pixels; }
+
+    /**
+     * Get all the pixels, row by row.
+     */
+    span<const Pixel> get_pixels() const noexcept { return pixels; }
+
+private:
+    std::vector<Pixel> pixels;
+    Transform origin;
+    Size size;
+};
+} // namespace uppr::term
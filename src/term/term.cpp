@@ -2,38 +2,108 @@
 #include "term.hpp"
 #include "term/termios.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cstdlib>
+#include <poll.h>
 #include <unistd.h>
 
 namespace uppr::term {
 
 Term::Term(int input_file_desc, FILE *output_file)
-    : in{input_file_desc}, out{output_file},
+    : in{input_file_desc}, out{output_file}, outbuf{fileno(output_file)},
       old_termios(get_termios(in)), current_termios{old_termios} {
     // Get the size of the terminal and save it
     update_size();
 
     uncook_termios();
+
+    // The environment says what the terminal claims to be, the probe may
+    // find out that it can do more than that
+    color_depth = color_depth_from_env(std::getenv("COLORTERM"),
+                                       std::getenv("TERM"));
+    probe_capabilities();
+
+    // SYNC_OUTPUT=0 or SYNC_OUTPUT=1 override the probe, for terminals that lie
+    const auto env_sync = std::getenv("SYNC_OUTPUT");
+    if (env_sync && env_sync == "0"sv) sync_output = false;
+    if (env_sync && env_sync == "1"sv) sync_output = true;
+
+    // And COLOR_DEPTH=16, 256 or truecolor overrides both for colors
+    const auto env_depth = std::getenv("COLOR_DEPTH");
+    if (env_depth && env_depth == "16"sv) color_depth = ColorDepth::ansi16;
+    if (env_depth && env_depth == "256"sv) color_depth = ColorDepth::ansi256;
+    if (env_depth && env_depth == "truecolor"sv)
+        color_depth = ColorDepth::truecolor;
+
+    sgr.set_depth(color_depth);
+
+    LOG_F(INFO, "Synchronized output is {}, left/right margins are {}",
+          sync_output ? "enabled" : "disabled",
+          lr_margins ? "supported" : "unsupported");
+    LOG_F(INFO, "Sending colors for {}", color_depth_name(color_depth));
 }
 
-Term::~Term() { cook_termios(); }
+Term::Term(Size size, int output_file_descr)
+    : width{static_cast<uint>(size.getx())},
+      height{static_cast<uint>(size.gety())}, in{-1}, out{nullptr},
+      outbuf{output_file_descr}, lr_margins{true}, headless{true} {}
+
+Term::Term(Size size, OutputSink sink)
+    : width{static_cast<uint>(size.getx())},
+      height{static_cast<uint>(size.gety())}, in{-1}, out{nullptr},
+      outbuf{std::move(sink)}, lr_margins{true}, headless{true} {}
 
-void Term::restore_termios() const { set_termios(in, old_termios); }
+Term::~Term() {
+    if (!headless) cook_termios();
 
-void Term::save_cursor() const { fwrite(out, "\x1B[s"sv, true); }
+    const auto &stats = get_output_stats();
+    LOG_F(INFO, "Terminal output: {} bytes in {} syscalls over {} flushes",
+          stats.bytes, stats.syscalls, stats.flushes);
+    LOG_F(INFO, "Style sequences: {} cached, {} formatted", sgr.get_hits(),
+          sgr.get_misses());
+}
 
-void Term::restore_cursor() const { fwrite(out, "\x1B[u"sv, true); }
+void Term::restore_termios() const {
+    if (!headless) set_termios(in, old_termios);
+}
 
-void Term::hide_cursor() const { fwrite(out, "\x1B[?25l"sv, true); }
+void Term::save_cursor() { write("\x1B[s"sv, true); }
 
-void Term::show_cursor() const { fwrite(out, "\x1B[?25h"sv, true); }
+void Term::restore_cursor() { write("\x1B[u"sv, true); }
 
-void Term::clear_term() const { fwrite(out, "\x1B[2J"sv, true); }
+void Term::hide_cursor() { write("\x1B[?25l"sv, true); }
+
+void Term::show_cursor() { write("\x1B[?25h"sv, true); }
+
+void Term::clear_term() {
+    // Erasing uses the current background color, so go back to the default
+    set_style({});
+    write("\x1B[2J"sv, true);
+}
 
-void Term::move_cursor(usize x, usize y) const {
-    // x and y are inverted in the command
-    fprintf(out, "\x1B[%lu;%luH", y + 1, x + 1);
-    fflush(out);
+void Term::move_cursor(usize x, usize y) {
+    write(absolute_motion({x, y}).view());
+}
+
+void Term::scroll_region(usize x, usize y, usize w, usize h, int lines) {
+    // The exposed lines are filled with the current background
+    set_style({});
+
+    const bool partial = x != 0 || w != width;
+    if (partial) print("\x1B[?69h\x1B[{};{}s", x + 1, x + w);
+    print("\x1B[{};{}r", y + 1, y + h);
+
+    if (lines > 0)
+        print("\x1B[{}S", lines);
+    else
+        print("\x1B[{}T", -lines);
+
+    // Reset the margins back to the whole screen. With DECLRMM set `CSI s` is
+    // DECSLRM, so it has to go before the mode is reset.
+    if (partial) write("\x1B[s\x1B[?69l"sv);
+    write("\x1B[r"sv);
 }
 
 void Term::set_termios_control(cc_t time, cc_t min) {
@@ -46,20 +116,29 @@ void Term::set_termios_control(cc_t time, cc_t min) {
 }
 
 void Term::commit_termios(bool flush) const {
+    if (headless) return;
     set_termios(in, current_termios, flush ? TCSAFLUSH : TCSANOW);
 }
 
-void Term::enable_alternative() const { fwrite(out, "\x1B[?1049h"sv, true); }
+void Term::enable_alternative() { write("\x1B[?1049h"sv, true); }
+
+void Term::disable_alternative() { write("\x1B[?1049l"sv, true); }
 
-void Term::disable_alternative() const { fwrite(out, "\x1B[?1049l"sv, true); }
+void Term::enable_bracketed_paste() { write("\x1B[?2004h"sv, true); }
 
-void Term::save_screen() const { fwrite(out, "\x1B[?47h"sv, true); }
+void Term::disable_bracketed_paste() { write("\x1B[?2004l"sv, true); }
 
-void Term::restore_screen() const { fwrite(out, "\x1B[?47l"sv, true); }
+void Term::save_screen() { write("\x1B[?47h"sv, true); }
+
+void Term::restore_screen() { write("\x1B[?47l"sv, true); }
 
 void Term::cook_termios() {
     restore_termios();
 
+    // Dont leave our colors behind for whoever uses the terminal next
+    set_style({});
+
+    disable_bracketed_paste();
     disable_alternative();
     restore_screen();
     restore_cursor();
@@ -77,26 +156,9 @@ void Term::uncook_termios() {
     save_cursor();
     save_screen();
     enable_alternative();
-}
 
-void Term::cook_termios_with_preserved_alt() {
-    LOG_SCOPE_FUNCTION(9);
-    restore_termios();
-
-    restore_cursor();
-    show_cursor();
-}
-
-void Term::uncook_termios_and_preserve_alt() {
-    LOG_SCOPE_FUNCTION(9);
-    uncook_current_termios_s();
-    set_termios_control(in_time, in_min);
-
-    commit_termios();
-
-    // Push the alternate, so that we can do whatever we want.
-    hide_cursor();
-    save_cursor();
+    // Pastes come as a whole instead of as keys
+    enable_bracketed_paste();
 }
 
 void Term::uncook_current_termios_s() {
@@ -132,26 +194,166 @@ void Term::uncook_current_termios_s() {
     current_termios.c_cflag |= CS8;
 }
 
-void Term::fwrite(FILE *f, string_view text, bool flush) const {
-    ::fwrite(text.data(), sizeof(string_view::value_type), text.size(), out);
-    if (flush) fflush(f);
+void Term::write(string_view text, bool flush) {
+    outbuf.append(text);
+    if (flush) outbuf.flush();
 }
 
 char Term::readc() const {
-    char c;
+    if (headless) return 0;
+
+    char c{};
     ::read(in, &c, 1);
 
     return c;
 }
 
 string_view Term::read(span<char> buf) const {
+    if (headless) return {};
+
     const auto n = ::read(in, buf.data(), buf.size());
     if (n <= 0) return {};
 
     return {buf.data(), static_cast<usize>(n)};
 }
 
+namespace {
+
+/**
+ * If `reply` ends with a whole `CSI ? Ps ; ... final` sequence. Only looking
+ * at the last byte is not enough, as it may also be in the middle of another
+ * reply (like the hex of XTGETTCAP).
+ */
+bool ends_with_reply(string_view reply, char final) {
+    if (reply.empty() || reply.back() != final) return false;
+
+    reply.remove_suffix(1);
+    while (!reply.empty() && (std::isdigit(static_cast<uchar>(reply.back())) ||
+                              reply.back() == ';'))
+        reply.remove_suffix(1);
+
+    return reply.ends_with("\x1B[?");
+}
+} // namespace
+
+std::string Term::query(string_view request, char terminator,
+                        std::chrono::milliseconds timeout) {
+    using clock = std::chrono::steady_clock;
+
+    // Send anything still pending too, the reply comes after it
+    write(request, true);
+
+    std::string reply;
+    const auto deadline = clock::now() + timeout;
+    while (!ends_with_reply(reply, terminator)) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - clock::now());
+        if (left.count() <= 0) break;
+
+        pollfd pfd{.fd = in, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, static_cast<int>(left.count())) <= 0) break;
+
+        char buf[64];
+        const auto n = ::read(in, buf, sizeof(buf));
+        if (n <= 0) break;
+
+        reply.append(buf, static_cast<usize>(n));
+    }
+
+    return reply;
+}
+
+namespace {
+
+/**
+ * Find the answer for DEC private `mode` in a DECRPM reply, that looks like
+ * `CSI ? mode ; Ps $ y`. Ps is 0 for unknown modes, 1/2 for set/reset and 3/4
+ * for permanently set/reset.
+ */
+bool mode_supported(string_view reply, string_view mode) {
+    const auto prefix = fmt::format("\x1B[?{};", mode);
+    const auto at = reply.find(prefix);
+    if (at == string_view::npos || at + prefix.size() >= reply.size())
+        return false;
+
+    const auto ps = reply[at + prefix.size()];
+    return ps == '1' || ps == '2' || ps == '3';
+}
+
+/**
+ * Find the value of terminfo capability `hex_name` (the name in hex) in a
+ * XTGETTCAP reply, that looks like `DCS 1 + r name = value ST` with the value
+ * in hex too. Returns nullopt if it was not answered, and an empty string for
+ * boolean capabilities.
+ */
+optional<std::string> termcap_value(string_view reply, string_view hex_name) {
+    // Terminals don't agree on the case of the hex digits
+    const auto lower = [](string_view s) {
+        std::string l{s};
+        std::transform(l.begin(), l.end(), l.begin(),
+                       [](char c) { return std::tolower(c); });
+        return l;
+    };
+
+    const auto prefix = lower(fmt::format("\x1BP1+r{}", hex_name));
+    const auto at = lower(reply).find(prefix);
+    if (at == std::string::npos) return {};
+
+    auto rest = reply.substr(at + prefix.size());
+    std::string value;
+    if (rest.empty() || rest.front() != '=') return value;
+    rest.remove_prefix(1);
+
+    const auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+
+    while (rest.size() >= 2 && hex(rest[0]) >= 0 && hex(rest[1]) >= 0) {
+        value.push_back(static_cast<char>(hex(rest[0]) << 4 | hex(rest[1])));
+        rest.remove_prefix(2);
+    }
+
+    return value;
+}
+} // namespace
+
+void Term::probe_capabilities() {
+    // Ask for the state of each mode (DECRQM) and for the `RGB` and `colors`
+    // terminfo capabilities (XTGETTCAP), followed by the primary device
+    // attributes. Every terminal answers the later, so we don't have to wait
+    // for the whole timeout on terminals that ignore the others.
+    const auto reply = query("\x1B[?2026$p\x1B[?69$p"
+                             "\x1BP+q524742\x1B\\\x1BP+q636F6C6F7273\x1B\\"
+                             "\x1B[c"sv,
+                             'c', std::chrono::milliseconds{200});
+    if (reply.empty()) {
+        LOG_F(WARNING, "Terminal did not answer the capability probe");
+        return;
+    }
+
+    sync_output = mode_supported(reply, "2026"sv);
+    lr_margins = mode_supported(reply, "69"sv);
+
+    // Only ever go up from what the environment said, as terminals answer
+    // with their terminfo entry and that may be older than the terminal
+    if (termcap_value(reply, "524742"sv)) {
+        color_depth = ColorDepth::truecolor;
+    } else if (const auto colors = termcap_value(reply, "636F6C6F7273"sv)) {
+        const auto n = std::atoi(colors->c_str());
+        if (n >= 1 << 24)
+            color_depth = ColorDepth::truecolor;
+        else if (n >= 256)
+            color_depth = std::max(color_depth, ColorDepth::ansi256);
+    }
+}
+
 void Term::update_size() {
+    // The size of a headless terminal is whatever it was created with
+    if (headless) return;
+
     const auto [w, h] = get_term_size(fileno(out));
 
     width = w;
@@ -3,10 +3,16 @@
 #include "commom.hpp"
 #include "fmt/color.h"
 #include "fmt/core.h"
+#include "motion.hpp"
+#include "outbuf.hpp"
+#include "sgr.hpp"
+#include "style.hpp"
 #include "term/key.hpp"
 #include "termios.hpp"
 #include "vector2.hpp"
+#include <chrono>
 #include <cstdio>
+#include <string>
 #include <unistd.h>
 #include <vector>
 
@@ -25,6 +31,22 @@ public:
      * state.
      */
     Term(int input_file_descr, FILE *output_file);
+
+    /**
+     * Create a headless `Term` of a fixed size, that writes to the given file
+     * descriptor (like `/dev/null`).
+     *
+     * A headless terminal never touches termios, has no input and assumes
+     * that the other side supports left/right margins.
+     */
+    Term(Size size, int output_file_descr);
+
+    /**
+     * Create a headless `Term` of a fixed size, that hands all output to the
+     * given sink (like a `VirtualTerminal`).
+     */
+    Term(Size size, OutputSink sink);
+
     ~Term();
 
 public:
@@ -39,17 +61,17 @@ public:
     /**
      * Hide the cursor.
      */
-    void hide_cursor() const;
+    void hide_cursor();
 
     /**
      * Show the cursor.
      */
-    void show_cursor() const;
+    void show_cursor();
 
     /**
      * Clear the terminal.
      */
-    void clear_term() const;
+    void clear_term();
 
     /**
      * Move the cursor to the given X, Y coordinates in the screen.
@@ -57,12 +79,12 @@ public:
      * NOTE: The normal coordinates in terminals are **1** based, but this
      * function corrects it to **0** based.
      */
-    void move_cursor(usize x, usize y) const;
+    void move_cursor(usize x, usize y);
 
     /**
      * Move the cursor to the home position.
      */
-    void home_cursor() const { fwrite(out, "\x1B[H"sv); }
+    void home_cursor() { write("\x1B[H"sv); }
 
     /**
      * Set the terminal timeout and minimum bytes before completion.
@@ -74,43 +96,48 @@ public:
      */
     void commit_termios(bool flush = true) const;
 
-    void danger_uncook() { uncook_termios(); }
-    void danger_cook() { cook_termios(); }
-    void danger_uncook_and_preserve_alt() { uncook_termios_and_preserve_alt(); }
-    void danger_cook_with_preserved_alt() { cook_termios_with_preserved_alt(); }
-
 private:
     // private termios control functions
 
     /**
      * Push the alternate screen.
      */
-    void enable_alternative() const;
+    void enable_alternative();
 
     /**
      * Pop the alternate screen.
      */
-    void disable_alternative() const;
+    void disable_alternative();
+
+    /**
+     * Have pasted text wrapped in `CSI 200 ~` and `CSI 201 ~`.
+     */
+    void enable_bracketed_paste();
+
+    /**
+     * Have pasted text sent as if it was typed.
+     */
+    void disable_bracketed_paste();
 
     /**
      * Save the current cursor position.
      */
-    void save_cursor() const;
+    void save_cursor();
 
     /**
      * Restore the last saved cursor position.
      */
-    void restore_cursor() const;
+    void restore_cursor();
 
     /**
      * Save the current screen contents.
      */
-    void save_screen() const;
+    void save_screen();
 
     /**
      * Restore the last saved screen contents.
      */
-    void restore_screen() const;
+    void restore_screen();
 
     /**
      * Do the full sequence of configurations to 'uncook' the terminal.
@@ -123,65 +150,129 @@ private:
     void cook_termios();
 
     /**
-     * Do the full sequence of configurations to 'uncook' the terminal without
-     * popping the alternate buffer.
+     * Setup the `current_termios` struct to be 'uncooked'.
      */
-    void uncook_termios_and_preserve_alt();
+    void uncook_current_termios_s();
+
+public:
+    // output functions
+    //
+    // Everything here is appended to the `outbuf` staging buffer, and only
+    // sent to the terminal on `flush()`.
 
     /**
-     * Do the full sequence of configurations to 'cook' the terminal without
-     * popping the alternate buffer.
+     * Append raw text to the output, optionally flushing it right away.
      */
-    void cook_termios_with_preserved_alt();
+    void write(string_view text, bool flush = false);
 
     /**
-     * Setup the `current_termios` struct to be 'uncooked'.
+     * Switch the terminal to the given style, emitting only what changed
+     * from the current style.
      */
-    void uncook_current_termios_s();
-
-public:
-    // output functions
+    void set_style(PackedStyle style) {
+        outbuf.append(sgr.transition(current_style, style));
+        current_style = style;
+    }
 
     /**
-     * wrapper for fwrite function.
+     * Get the style that the terminal is currently using.
      */
-    void fwrite(FILE *f, string_view text, bool flush = false) const;
+    PackedStyle get_style() const noexcept { return current_style; }
 
     template <typename... Args>
-    void print(fmt::format_string<Args...> fmt, Args &&...args) const {
+    void print(fmt::format_string<Args...> fmt, Args &&...args) {
         vprint(fmt, fmt::make_format_args(args...));
     }
 
     template <typename... Args>
     void print(const fmt::text_style &ts, fmt::format_string<Args...> fmt,
-               Args &&...args) const {
+               Args &&...args) {
         vprint(ts, fmt, fmt::make_format_args(args...));
     }
 
     template <typename... Args>
     void print(usize x, usize y, fmt::format_string<Args...> fmt,
-               Args &&...args) const {
+               Args &&...args) {
         move_cursor(x, y);
         vprint(fmt, fmt::make_format_args(args...));
     }
 
     template <typename... Args>
     void print(usize x, usize y, const fmt::text_style &ts,
-               fmt::format_string<Args...> fmt, Args &&...args) const {
+               fmt::format_string<Args...> fmt, Args &&...args) {
         move_cursor(x, y);
         vprint(ts, fmt, fmt::make_format_args(args...));
     }
 
-    void vprint(fmt::string_view fmt, fmt::format_args args) const {
-        fmt::vprint(out, fmt, args);
+    void vprint(fmt::string_view fmt, fmt::format_args args) {
+        outbuf.vformat(fmt, args);
     }
 
     void vprint(const fmt::text_style &ts, fmt::string_view fmt,
-                fmt::format_args args) const {
-        fmt::vprint(out, ts, fmt, args);
+                fmt::format_args args) {
+        // fmt expects to start from (and always goes back to) the default
+        set_style({});
+        outbuf.vformat(ts, fmt, args);
+    }
+
+    /**
+     * Send everything that was buffered to the terminal, with a single
+     * `write` whenever possible.
+     */
+    void flush() { outbuf.flush(); }
+
+    /**
+     * Start a synchronized update (DEC mode 2026), so that the terminal holds
+     * rendering until `end_sync_update()`. Does nothing if disabled.
+     */
+    void begin_sync_update() {
+        if (sync_output) write("\x1B[?2026h"sv);
     }
 
-    void flush() const { fflush(out); }
+    /**
+     * End a synchronized update started with `begin_sync_update()`.
+     */
+    void end_sync_update() {
+        if (sync_output) write("\x1B[?2026l"sv);
+    }
+
+    /**
+     * If frames are wrapped in synchronized update brackets.
+     */
+    constexpr bool get_sync_output() const { return sync_output; }
+
+    /**
+     * If the terminal supports left and right margins (DECLRMM), needed to
+     * scroll regions that are not as wide as the terminal.
+     */
+    constexpr bool get_lr_margins() const { return lr_margins; }
+
+    /**
+     * Get how many colors the terminal can show, which decides how styles
+     * are sent.
+     */
+    constexpr ColorDepth get_color_depth() const { return color_depth; }
+
+    /**
+     * Enable or disable the synchronized update brackets.
+     */
+    constexpr void set_sync_output(bool enable) { sync_output = enable; }
+
+    /**
+     * Scroll the contents of the rectangle at `x, y` of size `w, h` up by
+     * `lines` (or down, if negative), filling the exposed lines with blanks.
+     *
+     * Rectangles narrower than the terminal need `get_lr_margins()`. The
+     * cursor position is unknown afterwards.
+     */
+    void scroll_region(usize x, usize y, usize w, usize h, int lines);
+
+    /**
+     * Get the counters of bytes and syscalls used to write to the terminal.
+     */
+    const OutputStats &get_output_stats() const noexcept {
+        return outbuf.get_stats();
+    }
 
 public:
     // input functions
@@ -197,6 +288,22 @@ public:
      */
     string_view read(span<char> buf) const;
 
+    /**
+     * Send `request` to the terminal and collect the reply until it ends with
+     * a `CSI ? ... terminator` sequence, or until `timeout` runs out.
+     *
+     * Returns everything that was read, so an empty (or partial) string means
+     * that the terminal did not answer in time.
+     */
+    std::string query(string_view request, char terminator,
+                      std::chrono::milliseconds timeout);
+
+private:
+    /**
+     * Ask the terminal which of the optional modes that we use it supports.
+     */
+    void probe_capabilities();
+
 public:
     // Term class control functions
 
@@ -210,6 +317,17 @@ public:
      */
     constexpr Size get_size() const { return {width, height}; }
 
+    /**
+     * If this is not connected to a real terminal.
+     */
+    constexpr bool is_headless() const { return headless; }
+
+    /**
+     * Get the file descriptor that input is read from, to wait on it. This is
+     * negative for a headless terminal, as it has no input.
+     */
+    constexpr int get_input_fd() const { return headless ? -1 : in; }
+
 private:
     /**
      * Width of the terminal.
@@ -243,18 +361,56 @@ private:
 
     /**
      * The file that we use for output.
+     *
+     * NOTE: we only use this to get the file descriptor, all output goes
+     * through `outbuf` instead of stdio.
      */
     FILE *out;
 
+    /**
+     * Staging buffer for all output, so that a whole frame is sent at once.
+     */
+    OutputBuffer outbuf;
+
+    /**
+     * Precomputed escape sequences for style changes.
+     */
+    SgrCache sgr;
+
+    /**
+     * The style that the terminal is currently using for new text.
+     */
+    PackedStyle current_style{SgrCache::unknown};
+
+    /**
+     * How colors are sent. Headless terminals take them as they are.
+     */
+    ColorDepth color_depth{ColorDepth::truecolor};
+
+    /**
+     * If frames are wrapped in synchronized update brackets.
+     */
+    bool sync_output{};
+
+    /**
+     * If the terminal supports left and right margins.
+     */
+    bool lr_margins{};
+
+    /**
+     * If there is no real terminal on the other side.
+     */
+    bool headless{};
+
     /**
      * Store what was termios like before we messed with it.
      */
-    termios old_termios;
+    termios old_termios{};
 
     /**
      * Store the current termios, so we dont need to do a full API call to
      * `get_termios` every time we hit a special ambiguous character.
      */
-    termios current_termios;
+    termios current_termios{};
 };
 } // namespace uppr::term
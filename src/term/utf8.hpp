@@ -0,0 +1,85 @@
+/**
+ * @file Minimal UTF-8 encoding and decoding.
+ */
+
+#pragma once
+
+#include "commom.hpp"
+
+namespace uppr::term {
+
+/**
+ * The code point used in place of invalid sequences.
+ */
+static constexpr char32_t replacement_char = 0xFFFD;
+
+/**
+ * Encode a code point as UTF-8 into `out` (which must have room for 4 bytes).
+ *
+ * @return The number of bytes written.
+ */
+constexpr usize encode_utf8(char32_t c, char *out) noexcept {
+    if (c < 0x80) {
+        out[0] = static_cast<char>(c);
+        return 1;
+    }
+
+    if (c < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (c >> 6));
+        out[1] = static_cast<char>(0x80 | (c & 0x3F));
+        return 2;
+    }
+
+    if (c < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (c >> 12));
+        out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (c & 0x3F));
+        return 3;
+    }
+
+    out[0] = static_cast<char>(0xF0 | (c >> 18));
+    out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (c & 0x3F));
+    return 4;
+}
+
+/**
+ * Decode the code point at the start of `s`.
+ *
+ * Invalid or truncated sequences decode to `replacement_char` and consume a
+ * single byte, so that decoding always makes progress.
+ *
+ * @return The code point and how many bytes it used.
+ */
+constexpr std::pair<char32_t, usize> decode_utf8(string_view s) noexcept {
+    const auto b0 = static_cast<uchar>(s[0]);
+    if (b0 < 0x80) return {b0, 1};
+
+    usize len;
+    char32_t c;
+    if ((b0 & 0xE0) == 0xC0) {
+        len = 2;
+        c = b0 & 0x1F;
+    } else if ((b0 & 0xF0) == 0xE0) {
+        len = 3;
+        c = b0 & 0x0F;
+    } else if ((b0 & 0xF8) == 0xF0) {
+        len = 4;
+        c = b0 & 0x07;
+    } else {
+        return {replacement_char, 1};
+    }
+
+    if (s.size() < len) return {replacement_char, 1};
+
+    for (usize i = 1; i < len; i++) {
+        const auto b = static_cast<uchar>(s[i]);
+        if ((b & 0xC0) != 0x80) return {replacement_char, 1};
+
+        c = (c << 6) | (b & 0x3F);
+    }
+
+    return {c, len};
+}
+} // namespace uppr::term
@@ -0,0 +1,397 @@
+#include "virtual-term.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+
+namespace uppr::term {
+
+namespace {
+
+/**
+ * Length of the UTF-8 sequence started by `b`, or 1 if it is not a lead byte.
+ */
+constexpr usize utf8_length(uchar b) noexcept {
+    if ((b & 0xE0) == 0xC0) return 2;
+    if ((b & 0xF0) == 0xE0) return 3;
+    if ((b & 0xF8) == 0xF0) return 4;
+
+    return 1;
+}
+
+/**
+ * Bit of `fmt::emphasis` that each SGR code from 1 to 9 turns on (0 for the
+ * unused 6).
+ */
+constexpr array<u8, 10> emphasis_on{{0, 1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4,
+                                     0, 1 << 5, 1 << 6, 1 << 7}};
+
+/**
+ * Bits of `fmt::emphasis` that each SGR code from 20 to 29 turns off.
+ */
+constexpr array<u8, 10> emphasis_off{{0, 0, 0b11, 1 << 2, 1 << 3, 1 << 4, 0,
+                                      1 << 5, 1 << 6, 1 << 7}};
+} // namespace
+
+VirtualTerminal::VirtualTerminal(Size size)
+    : width{static_cast<uint>(std::max<usize>(size.getx(), 1))},
+      height{static_cast<uint>(std::max<usize>(size.gety(), 1))},
+      cells(width * height), bottom{height - 1u}, right{width - 1u} {}
+
+std::string VirtualTerminal::row_text(usize y) const {
+    std::string text;
+    for (usize x{}; x < width; x++) {
+        char encoded[4];
+        text.append(encoded, encode_utf8(at(x, y).get_glyph(), encoded));
+    }
+
+    return text;
+}
+
+void VirtualTerminal::feed(string_view bytes) {
+    stats.bytes += bytes.size();
+    stats.writes++;
+
+    // Finish the code point that was split on the last call
+    std::string joined;
+    if (!partial.empty()) {
+        joined = partial + std::string{bytes};
+        partial.clear();
+        bytes = joined;
+    }
+
+    while (!bytes.empty()) {
+        const char c = bytes.front();
+
+        switch (state) {
+        case State::ground:
+            if (c == '\x1B') {
+                state = State::escape;
+                stats.escapes++;
+            } else if (c == '\n') {
+                line_feed();
+                stats.controls++;
+            } else if (c == '\r') {
+                cx = lr_mode ? left : 0;
+                pending_wrap = false;
+                stats.controls++;
+            } else if (c == '\b') {
+                if (cx > 0) cx--;
+                pending_wrap = false;
+                stats.controls++;
+            } else if (static_cast<uchar>(c) < 0x20) {
+                stats.controls++;
+            } else {
+                const auto len = utf8_length(static_cast<uchar>(c));
+                if (bytes.size() < len) {
+                    partial = std::string{bytes};
+                    return;
+                }
+
+                const auto [glyph, n] = decode_utf8(bytes);
+                print(glyph);
+                bytes.remove_prefix(n);
+                continue;
+            }
+            break;
+
+        case State::escape:
+            if (c == '[') {
+                state = State::csi;
+                params.assign(1, 0);
+                prefix = 0;
+                intermediate = 0;
+            } else {
+                // Two byte escapes (like `ESC 7`) are not something we send
+                state = State::ground;
+                unknown++;
+            }
+            break;
+
+        case State::csi:
+            if (c >= '0' && c <= '9') {
+                params.back() = params.back() * 10 + (c - '0');
+            } else if (c == ';') {
+                params.push_back(0);
+            } else if (c >= '<' && c <= '?') {
+                prefix = c;
+            } else if (c >= ' ' && c <= '/') {
+                intermediate = c;
+            } else {
+                csi(c);
+                state = State::ground;
+            }
+            break;
+        }
+
+        bytes.remove_prefix(1);
+    }
+}
+
+void VirtualTerminal::print(char32_t c) {
+    if (pending_wrap) {
+        cx = lr_mode ? left : 0;
+        line_feed();
+        pending_wrap = false;
+    }
+
+    cells[cy * width + cx] = Pixel{c, style};
+    stats.glyphs++;
+
+    const auto last = (lr_mode && cx <= right) ? right : width - 1u;
+    if (cx < last)
+        cx++;
+    else
+        pending_wrap = true;
+}
+
+void VirtualTerminal::line_feed() {
+    pending_wrap = false;
+
+    if (cy == bottom)
+        scroll(1);
+    else if (cy + 1 < height)
+        cy++;
+}
+
+void VirtualTerminal::csi(char final) {
+    const auto n = param(0);
+
+    // Anything with an intermediate byte (like DECRQM `$p`) is a query or
+    // something else that does not change the screen
+    if (intermediate) {
+        unknown++;
+        return;
+    }
+
+    if (prefix == '?') {
+        if (final != 'h' && final != 'l') {
+            unknown++;
+            return;
+        }
+
+        const bool set = final == 'h';
+        for (const auto mode : params) {
+            switch (mode) {
+            case 69:
+                lr_mode = set;
+                if (!set) {
+                    left = 0;
+                    right = width - 1u;
+                }
+                break;
+            case 47:
+            case 1049:
+                // Switching screens, start from a blank one
+                std::fill(cells.begin(), cells.end(), Pixel{});
+                break;
+            case 25:
+            case 2026:
+                // Cursor visibility and synchronized updates don't change
+                // what is in the grid
+                break;
+            default:
+                unknown++;
+            }
+        }
+
+        return;
+    }
+
+    if (prefix) {
+        unknown++;
+        return;
+    }
+
+    pending_wrap = false;
+
+    switch (final) {
+    case 'H':
+    case 'f':
+        cy = std::min<usize>(param(0), height) - 1;
+        cx = std::min<usize>(param(1), width) - 1;
+        break;
+    case 'A': {
+        // Stops at the top margin, unless already above it
+        const usize limit = cy >= top ? top : 0;
+        cy = cy - limit >= n ? cy - n : limit;
+        break;
+    }
+    case 'B': {
+        // Stops at the bottom margin, unless already below it
+        const usize limit = cy <= bottom ? bottom : height - 1u;
+        cy = std::min(cy + n, limit);
+        break;
+    }
+    case 'C':
+        cx = std::min<usize>(cx + n, width - 1u);
+        break;
+    case 'D':
+        cx = cx >= n ? cx - n : 0;
+        break;
+    case 'G':
+        cx = std::min<usize>(n, width) - 1;
+        break;
+    case 'J':
+        switch (param(0, 0)) {
+        case 0:
+            erase(cy, cx, width);
+            for (usize y{cy + 1}; y < height; y++) erase(y, 0, width);
+            break;
+        case 1:
+            for (usize y{}; y < cy; y++) erase(y, 0, width);
+            erase(cy, 0, cx + 1);
+            break;
+        default:
+            for (usize y{}; y < height; y++) erase(y, 0, width);
+        }
+        break;
+    case 'K':
+        switch (param(0, 0)) {
+        case 0: erase(cy, cx, width); break;
+        case 1: erase(cy, 0, cx + 1); break;
+        default: erase(cy, 0, width);
+        }
+        break;
+    case 'm':
+        sgr();
+        break;
+    case 'r':
+        // DECSTBM, which also homes the cursor
+        top = std::min<usize>(param(0), height) - 1;
+        bottom = std::min<usize>(param(1, height), height) - 1;
+        if (bottom <= top) {
+            top = 0;
+            bottom = height - 1u;
+        }
+        cx = cy = 0;
+        break;
+    case 's':
+        if (lr_mode) {
+            // DECSLRM, which also homes the cursor
+            left = std::min<usize>(param(0), width) - 1;
+            right = std::min<usize>(param(1, width), width) - 1;
+            if (right <= left) {
+                left = 0;
+                right = width - 1u;
+            }
+            cx = cy = 0;
+        } else {
+            saved_x = cx;
+            saved_y = cy;
+        }
+        break;
+    case 'u':
+        cx = saved_x;
+        cy = saved_y;
+        break;
+    case 'S':
+        scroll(static_cast<int>(n));
+        break;
+    case 'T':
+        scroll(-static_cast<int>(n));
+        break;
+    case 'c':
+        // Device attributes query
+        break;
+    default:
+        unknown++;
+    }
+}
+
+void VirtualTerminal::sgr() {
+    u8 ems = style.emphasis();
+    u64 fg = style.fg_bits();
+    u64 bg = style.bg_bits();
+
+    // Extended colors are `38;5;n` or `38;2;r;g;b`
+    const auto extended = [&](usize &i) -> u64 {
+        if (i + 1 >= params.size()) return 0;
+
+        if (params[i + 1] == 2 && i + 4 < params.size()) {
+            const auto rgb = (params[i + 2] & 0xFF) << 16 |
+                             (params[i + 3] & 0xFF) << 8 |
+                             (params[i + 4] & 0xFF);
+            i += 4;
+            return PackedStyle::color_set_bit | PackedStyle::color_rgb_bit |
+                   rgb;
+        }
+
+        if (params[i + 1] == 5 && i + 2 < params.size()) {
+            const auto idx = params[i + 2];
+            i += 2;
+
+            // Only the 16 basic colors fit in a packed style
+            if (idx < 8) return PackedStyle::color_set_bit | (30 + idx);
+            if (idx < 16) return PackedStyle::color_set_bit | (90 + idx - 8);
+            unknown++;
+        }
+
+        return 0;
+    };
+
+    for (usize i{}; i < params.size(); i++) {
+        const auto p = params[i];
+
+        if (p == 0) {
+            ems = 0;
+            fg = bg = 0;
+        } else if (p < 10) {
+            ems |= emphasis_on[p];
+        } else if (p >= 20 && p < 30) {
+            ems &= ~emphasis_off[p - 20];
+        } else if ((p >= 30 && p <= 37) || (p >= 90 && p <= 97)) {
+            fg = PackedStyle::color_set_bit | p;
+        } else if ((p >= 40 && p <= 47) || (p >= 100 && p <= 107)) {
+            bg = PackedStyle::color_set_bit | (p - 10);
+        } else if (p == 38) {
+            fg = extended(i);
+        } else if (p == 48) {
+            bg = extended(i);
+        } else if (p == 39) {
+            fg = 0;
+        } else if (p == 49) {
+            bg = 0;
+        } else {
+            unknown++;
+        }
+    }
+
+    style = PackedStyle::from_bits(
+        fg << PackedStyle::fg_shift | bg << PackedStyle::bg_shift |
+        static_cast<u64>(ems) << PackedStyle::emphasis_shift);
+}
+
+void VirtualTerminal::scroll(int n) {
+    const auto rows = bottom - top + 1;
+    const auto count = std::min<usize>(static_cast<usize>(std::abs(n)), rows);
+    const auto cols = right - left + 1;
+
+    const auto move_row = [&](usize dst, usize src) {
+        std::copy_n(&cells[src * width + left], cols,
+                    &cells[dst * width + left]);
+    };
+
+    if (n > 0) {
+        for (usize y{top}; y + count <= bottom; y++) move_row(y, y + count);
+        for (usize y{bottom + 1 - count}; y <= bottom; y++)
+            erase(y, left, right + 1);
+    } else {
+        for (usize y{bottom}; y >= top + count; y--) move_row(y, y - count);
+        for (usize y{top}; y < top + count; y++) erase(y, left, right + 1);
+    }
+}
+
+void VirtualTerminal::erase(usize y, usize from, usize to) {
+    // Erasing uses the current background color, but nothing else
+    const auto blank = PackedStyle::from_bits(style.bg_bits()
+                                              << PackedStyle::bg_shift);
+    std::fill(&cells[y * width + from], &cells[y * width + to],
+              Pixel{U' ', blank});
+}
+
+usize VirtualTerminal::param(usize i, usize def) const {
+    if (i >= params.size() || params[i] == 0) return def;
+
+    return params[i];
+}
+} // namespace uppr::term
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "commom.hpp"
+#include "motion.hpp"
+#include "outbuf.hpp"
+#include "pixel.hpp"
+#include "style.hpp"
+#include "vector2.hpp"
+
+#include <string>
+#include <vector>
+
+namespace uppr::term {
+
+/**
+ * Counters of what a `VirtualTerminal` received.
+ */
+struct VirtualStats {
+    /**
+     * Total number of bytes received.
+     */
+    usize bytes{};
+
+    /**
+     * Number of times that output was handed to the terminal (each would be a
+     * `write` syscall on a real one).
+     */
+    usize writes{};
+
+    /**
+     * Number of escape sequences (CSI or otherwise).
+     */
+    usize escapes{};
+
+    /**
+     * Number of glyphs printed.
+     */
+    usize glyphs{};
+
+    /**
+     * Number of control characters (line feeds, carriage returns, etc).
+     */
+    usize controls{};
+};
+
+/**
+ * A tiny in-memory terminal emulator.
+ *
+ * This understands exactly the subset of VT100/xterm that `Term` emits
+ * (cursor motion, SGR, erasing, scroll regions with left/right margins and
+ * the private modes we toggle), and parses it back into a grid of pixels. It
+ * is meant to be plugged into a headless `TermScreen` for checking and
+ * benchmarking the renderer without a real terminal.
+ *
+ * Anything that it does not understand is counted and ignored.
+ */
+class VirtualTerminal {
+public:
+    /**
+     * Create a blank terminal of the given size.
+     */
+    explicit VirtualTerminal(Size size);
+
+public:
+    /**
+     * Parse more output. Sequences can be split between calls.
+     */
+    void feed(string_view bytes);
+
+    /**
+     * Get a sink that feeds this terminal, for a headless `TermScreen`.
+     *
+     * The terminal must outlive whoever uses the sink.
+     */
+    OutputSink sink() {
+        return [this](string_view bytes) { feed(bytes); };
+    }
+
+public:
+    /**
+     * Get the size of the terminal.
+     */
+    constexpr Size get_size() const noexcept { return {width, height}; }
+
+    /**
+     * Get the pixel at the given coordinates.
+     */
+    const Pixel &at(usize x, usize y) const { return cells[y * width + x]; }
+
+    /**
+     * Get every pixel, row by row (the same layout as `TermScreen`).
+     */
+    span<const Pixel> get_cells() const noexcept { return cells; }
+
+    /**
+     * Get the text of a line, without styles.
+     */
+    std::string row_text(usize y) const;
+
+    /**
+     * Get where the cursor is.
+     */
+    constexpr CursorPos get_cursor() const noexcept { return {cx, cy}; }
+
+    /**
+     * Get the style that new text would be printed with.
+     */
+    constexpr PackedStyle get_style() const noexcept { return style; }
+
+    /**
+     * Get the counters of what was received so far.
+     */
+    const VirtualStats &get_stats() const noexcept { return stats; }
+
+    /**
+     * Number of sequences that were ignored because they are not supported.
+     */
+    usize get_unknown() const noexcept { return unknown; }
+
+private:
+    /**
+     * Print a single glyph at the cursor, wrapping if needed.
+     */
+    void print(char32_t c);
+
+    /**
+     * Move down a line, scrolling if at the bottom margin.
+     */
+    void line_feed();
+
+    /**
+     * Run a complete CSI sequence.
+     */
+    void csi(char final);
+
+    /**
+     * Run a SGR sequence with the collected parameters.
+     */
+    void sgr();
+
+    /**
+     * Scroll the region between the margins up by `n` (or down, if negative).
+     */
+    void scroll(int n);
+
+    /**
+     * Erase (with the current background) the given columns of a line.
+     */
+    void erase(usize y, usize from, usize to);
+
+    /**
+     * Get the `i`th parameter, or `def` if missing or zero.
+     */
+    usize param(usize i, usize def = 1) const;
+
+private:
+    enum class State { ground, escape, csi };
+
+    uint width;
+    uint height;
+
+    std::vector<Pixel> cells;
+
+    usize cx{}, cy{};
+    usize saved_x{}, saved_y{};
+
+    /**
+     * Printing on the last column leaves the cursor there, and only the next
+     * glyph wraps.
+     */
+    bool pending_wrap{};
+
+    PackedStyle style;
+
+    // Margins, all inclusive
+    usize top{}, bottom{}, left{}, right{};
+
+    /**
+     * DECLRMM, private mode 69.
+     */
+    bool lr_mode{};
+
+    State state{State::ground};
+
+    /**
+     * Parameters of the CSI being parsed.
+     */
+    std::vector<usize> params;
+
+    /**
+     * Prefix (like `?`) and intermediate (like `$`) bytes of the CSI.
+     */
+    char prefix{};
+    char intermediate{};
+
+    /**
+     * Bytes of an UTF-8 sequence that was split between calls to `feed`.
+     */
+    std::string partial;
+
+    VirtualStats stats;
+    usize unknown{};
+};
+} // namespace uppr::term